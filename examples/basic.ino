@@ -7,12 +7,13 @@ void setup() {
     Serial.println("Starting up OPT3002...");
 
     Wire.begin();
+    sensor.begin();
 
     // Set configuration parameters.
-    sensor.config.conversion_time = OPT3002_CONVERSION_TIME::ILLU_800MS;
-    sensor.config.mode = OPT3002_MODE::CONTINUOUS;
-    sensor.config.range = OPT3002_RANGE::OPT3002_RANGE_AUTO;
-    sensor.begin();
+    sensor.set_conversion_time(OPT3002_CONV_TIME_800MS);
+    sensor.set_mode(OPT3002_MODE_CONTINUOUS);
+    sensor.set_range(OPT3002_RANGE_AUTO);
+    sensor.commit();
 }
 
 void loop() {
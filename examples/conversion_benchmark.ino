@@ -0,0 +1,59 @@
+#include "OPT3002.h"
+
+// Times the float and integer result conversions on the target MCU.
+// For flash usage, build once as-is and once with OPT3002_NO_FLOAT defined
+// in the build flags (and the float section below removed), then compare
+// the reported sketch sizes.
+
+const uint16_t ITERATIONS = 4096;
+
+volatile uint32_t sink;
+
+void setup() {
+    Serial.begin(115200);
+
+    opt3002_result_t result;
+    uint32_t start;
+    uint32_t elapsed;
+
+#if !defined(OPT3002_NO_FLOAT)
+    OPT3002 sensor;
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        result.raw = i * 16 + 7;
+        sink = sensor.convert_measurement(result);
+    }
+    elapsed = micros() - start;
+    Serial.print("float path:   ");
+    Serial.print(elapsed * 1000UL / ITERATIONS);
+    Serial.print(" ns/call, ");
+    Serial.print(elapsed * (F_CPU / 1000000UL) / ITERATIONS);
+    Serial.println(" cycles/call");
+#endif
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        result.raw = i * 16 + 7;
+        sink = OPT3002::convert_to_nw(result);
+    }
+    elapsed = micros() - start;
+    Serial.print("integer nW:   ");
+    Serial.print(elapsed * 1000UL / ITERATIONS);
+    Serial.print(" ns/call, ");
+    Serial.print(elapsed * (F_CPU / 1000000UL) / ITERATIONS);
+    Serial.println(" cycles/call");
+
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+        result.raw = i * 16 + 7;
+        sink = OPT3002::convert_to_nw_x10(result);
+    }
+    elapsed = micros() - start;
+    Serial.print("integer nW/10: ");
+    Serial.print(elapsed * 1000UL / ITERATIONS);
+    Serial.print(" ns/call, ");
+    Serial.print(elapsed * (F_CPU / 1000000UL) / ITERATIONS);
+    Serial.println(" cycles/call");
+}
+
+void loop() {}
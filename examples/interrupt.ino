@@ -0,0 +1,30 @@
+#include "OPT3002_async.h"
+
+// Connect the sensor's INT pin here (with a pull-up; INT is active-low)
+const uint8_t INT_PIN = 2;
+
+OPT3002 sensor;
+OPT3002ArduinoClock clock;
+OPT3002InterruptReader reader(sensor, clock);
+
+void on_int_pin() { reader.notify(); }
+
+void setup() {
+    Serial.begin(115200);
+    Wire.begin();
+
+    sensor.begin();
+    pinMode(INT_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(INT_PIN), on_int_pin, FALLING);
+    reader.begin(OPT3002_CONV_TIME_100MS, OPT3002_ACTIVE_LOW);
+}
+
+void loop() {
+    // Only touches the bus after the INT pin has signalled a new conversion
+    if (reader.service()) {
+        opt3002_sample_t sample = reader.take();
+        Serial.print("Reading: ");
+        Serial.print(OPT3002::convert_to_nw(sample.result));
+        Serial.println(" nW/cm2");
+    }
+}
@@ -0,0 +1,35 @@
+#include "OPT3002_bus.h"
+
+// Up to four sensors on one bus, one per ADDR pin option (0x44-0x47)
+OPT3002WireTransport transport;
+OPT3002ArduinoClock clock;
+OPT3002Bus sensors(transport, clock);
+
+void print_sample(const opt3002_sample_t &sample, void *context) {
+    Serial.print("0x");
+    Serial.print(sample.address, HEX);
+    Serial.print(": ");
+    Serial.print(OPT3002::convert_to_nw(sample.result));
+    Serial.println(" nW/cm2");
+}
+
+void setup() {
+    Serial.begin(115200);
+    Wire.begin();
+
+    Serial.print("Sensors found: ");
+    Serial.println(sensors.begin());
+    sensors.start(OPT3002_CONV_TIME_100MS);
+}
+
+void loop() {
+    sensors.service(print_sample);
+
+    static uint32_t last_report = 0;
+    if (millis() - last_report > 10000) {
+        last_report = millis();
+        Serial.print("Aggregate rate: ");
+        Serial.print(sensors.get_sample_rate_mhz() / 1000.0f);
+        Serial.println(" samples/s");
+    }
+}
@@ -0,0 +1,30 @@
+#include "OPT3002_async.h"
+
+OPT3002 sensor;
+OPT3002ArduinoClock clock;
+OPT3002Acquisition acquisition(sensor, clock);
+
+void print_sample(const opt3002_sample_t &sample, void *context) {
+    Serial.print("Reading: ");
+    Serial.print(OPT3002::convert_to_nw(sample.result));
+    Serial.println(" nW/cm2");
+}
+
+void setup() {
+    Serial.begin(115200);
+    Wire.begin();
+
+    sensor.begin();
+    sensor.set_conversion_time(OPT3002_CONV_TIME_800MS);
+    sensor.set_range(OPT3002_RANGE_AUTO);
+
+    acquisition.set_callback(print_sample);
+    acquisition.start(true);
+}
+
+void loop() {
+    // Never blocks; the sensor is only touched once each conversion is due
+    acquisition.poll();
+
+    // ... the rest of the main loop keeps running here
+}
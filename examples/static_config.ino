@@ -0,0 +1,19 @@
+#include "OPT3002_static.h"
+
+// Configuration fixed at build time: 80K range, 100ms continuous conversions
+OPT3002Static<OPT3002_RANGE_80K, OPT3002_CONV_TIME_100MS, OPT3002_MODE_CONTINUOUS> sensor;
+
+void setup() {
+    Serial.begin(115200);
+    Wire.begin();
+
+    // Writes the precomputed CONFIG word; no read-modify-write
+    sensor.begin();
+}
+
+void loop() {
+    Serial.print("Reading: ");
+    Serial.print(sensor.get_optical_power());
+    Serial.println(" nW/cm2");
+    delay(1000);
+}
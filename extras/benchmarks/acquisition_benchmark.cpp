@@ -0,0 +1,259 @@
+/**
+ * Simulator benchmark: synchronised and non-blocking acquisition.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Isrc extras/benchmarks/acquisition_benchmark.cpp src/OPT3002*.cpp -o acquisition_benchmark
+ *   ./acquisition_benchmark
+ *
+ * OPT3002Bus::acquire_all() with four simulated sensors on a 100 kHz bus,
+ * each under its own constant light level, for both conversion times. Each
+ * case is run with every sensor answering and again with the first one
+ * failing (NACKing every transaction) after setup.
+ *
+ * Reported per acquisition: sensors read, the trigger skew and the bus
+ * transactions and bytes used. Checked: every answering sensor delivers one
+ * sample carrying its own light level and its trigger time, and the skew is
+ * no more than one CONFIG write per additional triggered sensor.
+ *
+ * OPT3002Acquisition in repeat mode on one sensor, for both conversion times,
+ * with the main loop either sleeping until time_until_check() or spinning
+ * with a poll() every 1ms or 7ms. Reported per sample: CONFIG status reads
+ * and bus transactions and bytes. Each case has a bus budget of one status
+ * read per sample and the trigger, status and result transactions (the
+ * simulated bus has no combined write-read, so a register read after a
+ * pointer change is two transactions). Every sample must also carry the
+ * sensor's light level.
+ *
+ * Each OPT3002Acquisition case is run again on a bus that NACKs every 5th
+ * trigger, every 7th RESULT read and every 11th CONFIG read. There the
+ * budgets do not apply; instead all samples must still arrive within twice
+ * the time of the conversions, and get_bus_errors() must count every NACK.
+ *
+ * The exit status is non-zero if a check fails or a budget is exceeded.
+ */
+#include <stdio.h>
+
+#include "OPT3002_async.h"
+#include "OPT3002_bus.h"
+#include "OPT3002_simulator.h"
+
+static const uint8_t SENSORS = 4;
+
+// Light level of the sensor at index i, in nW/cm^2
+static float level_of(uint8_t index) { return 1000.0f * (index + 1); }
+
+/**
+ * The simulated bus, with one address that can be made to stop answering.
+ * A NACKed transaction still takes the bus for START, the address byte and
+ * STOP (11 clocks at 100 kHz).
+ */
+class FaultyTransport : public OPT3002Transport {
+   public:
+    FaultyTransport(OPT3002SimulatedBus &bus) : _bus(&bus), _failing(0) {}
+
+    void fail(uint8_t device_address) { _failing = device_address; }
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length) {
+        if (device_address == _failing) return nack();
+        return _bus->write(device_address, data, length);
+    }
+    bool read(uint8_t device_address, uint8_t *data, size_t length) {
+        if (device_address == _failing) return nack();
+        return _bus->read(device_address, data, length);
+    }
+
+   private:
+    OPT3002SimulatedBus *_bus;
+    uint8_t _failing;
+
+    bool nack() {
+        _bus->advance(110000);
+        return false;
+    }
+};
+
+/**
+ * The simulated bus, NACKing every nth trigger (CONFIG write), RESULT pointer
+ * write and CONFIG pointer write. A period of 0 never fails.
+ */
+class FlakyTransport : public OPT3002Transport {
+   public:
+    FlakyTransport(OPT3002SimulatedBus &bus, uint32_t trigger_period, uint32_t result_period, uint32_t status_period)
+        : _bus(&bus), _failures(0) {
+        _periods[0] = trigger_period;
+        _periods[1] = result_period;
+        _periods[2] = status_period;
+        _counts[0] = _counts[1] = _counts[2] = 0;
+    }
+
+    uint32_t get_failures() const { return _failures; }
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length) {
+        int kind = -1;
+        if (length == 3 and data[0] == 0x01) kind = 0;
+        if (length == 1 and data[0] == 0x00) kind = 1;
+        if (length == 1 and data[0] == 0x01) kind = 2;
+        if (kind >= 0 and _periods[kind] and ++_counts[kind] % _periods[kind] == 0) {
+            _failures++;
+            return false;
+        }
+        return _bus->write(device_address, data, length);
+    }
+    bool read(uint8_t device_address, uint8_t *data, size_t length) { return _bus->read(device_address, data, length); }
+
+   private:
+    OPT3002SimulatedBus *_bus;
+    uint32_t _periods[3];
+    uint32_t _counts[3];
+    uint32_t _failures;
+};
+
+static bool check(bool condition, const char *what) {
+    if (not condition) printf("    FAILED: %s\n", what);
+    return condition;
+}
+
+static bool run_acquire_all(opt3002_conv_time_t conversion_time, bool fail_first) {
+    OPT3002SimulatedBus bus;
+    OPT3002Simulator sensors[SENSORS];
+    for (uint8_t i = 0; i < SENSORS; i++) {
+        sensors[i] = OPT3002Simulator(OPT3002_DEFAULT_ADDRESS + i);
+        sensors[i].set_optical_power(level_of(i));
+        bus.attach(sensors[i]);
+    }
+
+    FaultyTransport transport(bus);
+    OPT3002Bus manager(transport, bus);
+    manager.begin();
+    for (uint8_t i = 0; i < SENSORS; i++) manager.get_device(i).set_conversion_time(conversion_time);
+
+    // Time on the wire of the CONFIG write that triggers a sensor
+    uint64_t before_ns = bus.get_time_ns();
+    manager.get_device(0).trigger();
+    uint32_t write_us = uint32_t((bus.get_time_ns() - before_ns + 999) / 1000);
+    bus.advance(1000000000ULL);
+    manager.get_device(0).refresh_flags();
+
+    if (fail_first) transport.fail(OPT3002_DEFAULT_ADDRESS);
+    uint8_t answering = fail_first ? SENSORS - 1 : SENSORS;
+
+    const int rounds = 10;
+    bool passed = true;
+    uint32_t worst_skew_us = 0;
+    bus.reset_counters();
+    for (int round = 0; round < rounds; round++) {
+        opt3002_sample_t samples[OPT3002Bus::MAX_DEVICES];
+        uint32_t started_us = bus.now_us();
+        uint8_t acquired = manager.acquire_all(samples);
+        uint32_t skew_us = manager.get_trigger_skew_us();
+        if (skew_us > worst_skew_us) worst_skew_us = skew_us;
+
+        passed &= check(acquired == answering, "one sample per answering sensor");
+        passed &= check(skew_us <= (answering - 1) * write_us, "skew within one CONFIG write per sensor");
+        for (uint8_t s = 0; s < acquired; s++) {
+            uint8_t index = samples[s].address - OPT3002_DEFAULT_ADDRESS;
+            float power = OPT3002::convert_to_nw_x10(samples[s].result) / 10.0f;
+            float expected = level_of(index);
+            passed &= check(not(fail_first and index == 0), "no sample from the failing sensor");
+            passed &= check(power > expected * 0.99f and power < expected * 1.01f, "sample matches its sensor's light");
+            passed &= check(samples[s].timestamp_us - started_us <= skew_us + write_us, "sample stamped with its trigger time");
+        }
+    }
+
+    printf("%-6s %-12s %7u %9u us %9.1f %9.1f   %s\n", conversion_time == OPT3002_CONV_TIME_100MS ? "100ms" : "800ms",
+           fail_first ? "first fails" : "all answer", answering, worst_skew_us, double(bus.get_transactions()) / rounds,
+           double(bus.get_bytes()) / rounds, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+/**
+ * Main loop styles for OPT3002Acquisition. A poll period of 0 sleeps until
+ * time_until_check(); otherwise poll() is called at that period.
+ */
+typedef struct {
+    const char *name;
+    uint32_t poll_period_us;
+} loop_style_t;
+
+static const loop_style_t LOOP_STYLES[] = {{"sleep", 0}, {"spin 1ms", 1000}, {"spin 7ms", 7000}};
+
+// Bus budget per sample: trigger write, CONFIG status read, RESULT read
+static const double MAX_STATUS_READS = 1.0;
+static const double MAX_TRANSACTIONS = 5.0;
+static const double MAX_BYTES = 14.0;
+
+static bool run_acquisition(opt3002_conv_time_t conversion_time, const loop_style_t &style, bool flaky) {
+    const float level = 5000.0f;
+    const uint32_t samples = 100;
+    uint64_t conversion_ns = conversion_time == OPT3002_CONV_TIME_100MS ? 100000000ULL : 800000000ULL;
+
+    OPT3002SimulatedBus bus;
+    OPT3002Simulator simulator;
+    simulator.set_optical_power(level);
+    bus.attach(simulator);
+
+    FlakyTransport transport(bus, 0, 0, 0);
+    OPT3002 sensor(transport);
+    sensor.begin();
+    sensor.set_conversion_time(conversion_time);
+    OPT3002Acquisition acquisition(sensor, bus);
+    if (flaky) transport = FlakyTransport(bus, 5, 7, 11);
+
+    bool passed = true;
+    bus.reset_counters();
+    acquisition.start(true);
+    // An acquisition that goes idle is caught by the time limit rather than hanging
+    uint64_t limit_ns = bus.get_time_ns() + 2 * samples * conversion_ns;
+    while (acquisition.get_samples() < samples and bus.get_time_ns() < limit_ns) {
+        if (style.poll_period_us) {
+            bus.sleep_us(style.poll_period_us);
+        } else {
+            bus.sleep_us(acquisition.time_until_check());
+        }
+        if (acquisition.poll()) {
+            float power = OPT3002::convert_to_nw_x10(acquisition.take().result) / 10.0f;
+            passed &= check(power > level * 0.99f and power < level * 1.01f, "sample matches the light level");
+        }
+    }
+    acquisition.stop();
+
+    // The conversion started by the last sample's repeat is not counted
+    double status_reads = double(acquisition.get_status_reads()) / samples;
+    double transactions = double(bus.get_transactions() - 1) / samples;
+    double bytes = double(bus.get_bytes() - 4) / samples;
+    passed &= check(acquisition.get_samples() == samples, "every sample delivered");
+    passed &= check(acquisition.get_bus_errors() == transport.get_failures(), "every NACK counted");
+    if (not flaky) {
+        passed &= check(status_reads <= MAX_STATUS_READS, "status reads within budget");
+        passed &= check(transactions <= MAX_TRANSACTIONS, "transactions within budget");
+        passed &= check(bytes <= MAX_BYTES, "bytes within budget");
+    }
+
+    printf("%-6s %-10s %-6s %13.2f %9.2f %9.2f %6u   %s\n", conversion_time == OPT3002_CONV_TIME_100MS ? "100ms" : "800ms", style.name,
+           flaky ? "flaky" : "clean", status_reads, transactions, bytes, acquisition.get_bus_errors(), passed ? "ok" : "FAILED");
+    return passed;
+}
+
+int main() {
+    printf("acquire_all(), %u sensors at 100 kHz\n", SENSORS);
+    printf("%-6s %-12s %7s %12s %9s %9s\n", "conv", "sensors", "read", "skew", "trans", "bytes");
+
+    bool passed = true;
+    const opt3002_conv_time_t times[] = {OPT3002_CONV_TIME_100MS, OPT3002_CONV_TIME_800MS};
+    for (size_t t = 0; t < 2; t++) {
+        passed = run_acquire_all(times[t], false) and passed;
+        passed = run_acquire_all(times[t], true) and passed;
+    }
+
+    printf("\nOPT3002Acquisition, per sample (budget %.0f status read, %.0f transactions, %.0f bytes)\n", MAX_STATUS_READS,
+           MAX_TRANSACTIONS, MAX_BYTES);
+    printf("%-6s %-10s %-6s %13s %9s %9s %6s\n", "conv", "loop", "bus", "status reads", "trans", "bytes", "errors");
+    for (int flaky = 0; flaky < 2; flaky++) {
+        for (size_t t = 0; t < 2; t++) {
+            for (size_t l = 0; l < sizeof(LOOP_STYLES) / sizeof(LOOP_STYLES[0]); l++) {
+                passed = run_acquisition(times[t], LOOP_STYLES[l], flaky) and passed;
+            }
+        }
+    }
+    return passed ? 0 : 1;
+}
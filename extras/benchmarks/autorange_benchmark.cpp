@@ -0,0 +1,147 @@
+/**
+ * Simulator benchmark: hardware auto-range against OPT3002AutoRange.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Isrc extras/benchmarks/autorange_benchmark.cpp src/OPT3002*.cpp -o autorange_benchmark
+ *   ./autorange_benchmark
+ *
+ * One simulated sensor runs continuous 100ms conversions under three light
+ * traces (step, ramp, flicker). Every conversion is read back along with its
+ * overflow flag. For each trace and ranging strategy the benchmark reports
+ * conversions lost to overflow, the mean error of the usable readings against
+ * the true light averaged over each conversion window, and for the software
+ * engine the range changes made and the conversions they cost.
+ *
+ * The software engine is also run on a bus that NACKs every third CONFIG
+ * write. Checked for every software run: after each update() the engine's
+ * range is the one the sensor is converting in, i.e. a failed range change is
+ * neither assumed to have happened nor lost. The exit status is non-zero if
+ * that check fails.
+ */
+#include <math.h>
+#include <stdio.h>
+
+#include "OPT3002_autorange.h"
+#include "OPT3002_simulator.h"
+
+static const uint64_t CONVERSION_NS = 100000000ULL;
+static const double RUN_SECONDS = 60;
+
+// Dark-to-bright step at 5.05s, back down at 35.05s (mid-conversion)
+static float step_trace(uint64_t time_ns, void *) {
+    double t = time_ns * 1e-9;
+    return (t >= 5.05 and t < 35.05) ? 2.0e6f : 500.0f;
+}
+
+// Exponential ramp 10 nW -> 5 mW over 30s and back
+static float ramp_trace(uint64_t time_ns, void *) {
+    double t = time_ns * 1e-9;
+    double phase = t < 30 ? t / 30 : (60 - t) / 30;
+    return float(10 * pow(5.0e5, phase));
+}
+
+// 90% deep 1.3 Hz flicker on 100 uW/cm^2
+static float flicker_trace(uint64_t time_ns, void *) {
+    double t = time_ns * 1e-9;
+    return float(1.0e5 * (1 + 0.9 * sin(2 * M_PI * 1.3 * t)));
+}
+
+// Same window average as the simulator uses
+static double window_mean(opt3002_light_source_t trace, uint64_t start_ns) {
+    double total = 0;
+    uint64_t step = CONVERSION_NS / 8;
+    for (int i = 0; i < 8; i++) total += trace(start_ns + step / 2 + step * i, NULL);
+    return total / 8;
+}
+
+/**
+ * The simulated bus, NACKing every nth CONFIG write (pointer and value).
+ * A period of 0 never fails.
+ */
+class ConfigFaultTransport : public OPT3002Transport {
+   public:
+    ConfigFaultTransport(OPT3002SimulatedBus &bus, uint32_t period) : _bus(&bus), _period(period), _writes(0) {}
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length) {
+        if (_period and length == 3 and data[0] == 0x01 and ++_writes % _period == 0) return false;
+        return _bus->write(device_address, data, length);
+    }
+    bool read(uint8_t device_address, uint8_t *data, size_t length) { return _bus->read(device_address, data, length); }
+
+   private:
+    OPT3002SimulatedBus *_bus;
+    uint32_t _period;
+    uint32_t _writes;
+};
+
+static bool run(const char *trace_name, opt3002_light_source_t trace, bool software, bool flaky = false) {
+    OPT3002SimulatedBus bus(0);
+    OPT3002Simulator simulator;
+    simulator.set_light_source(trace, NULL);
+    bus.attach(simulator);
+
+    ConfigFaultTransport transport(bus, 0);
+    OPT3002 sensor(transport);
+    sensor.begin();
+    OPT3002AutoRange engine(sensor);
+
+    sensor.set_conversion_time(OPT3002_CONV_TIME_100MS);
+    if (software) {
+        engine.begin(OPT3002_RANGE_40K);
+    } else {
+        sensor.set_range(OPT3002_RANGE_AUTO);
+    }
+    uint64_t start_ns = bus.get_time_ns();
+    sensor.set_mode(OPT3002_MODE_CONTINUOUS);
+    sensor.commit();
+    if (flaky) transport = ConfigFaultTransport(bus, 3);
+
+    uint32_t conversions = 0;
+    uint32_t overflows = 0;
+    uint32_t mismatches = 0;
+    double error_total = 0;
+    for (uint64_t k = 0; k < RUN_SECONDS * 10; k++) {
+        // Read just after each conversion completes
+        bus.advance_to(start_ns + (k + 1) * CONVERSION_NS + 1000);
+        opt3002_config_t flags = sensor.refresh_flags();
+        opt3002_result_t result;
+        sensor.get_result(result);
+        conversions++;
+
+        bool overflow = opt3002_config_flag(flags.raw, OPT3002_CONFIG_OVERFLOW);
+        if (software) {
+            engine.update(result, overflow);
+            if (opt3002_config_range(simulator.get_register(0x01)) != engine.get_range()) mismatches++;
+        }
+        if (overflow) {
+            overflows++;
+            continue;
+        }
+
+        double truth = window_mean(trace, start_ns + k * CONVERSION_NS);
+        double measured = OPT3002::convert_to_pw(result).picowatts * 1e-3;
+        error_total += fabs(measured - truth) / truth;
+    }
+
+    printf("%-8s %-9s %5u conversions %4u overflowed  mean error %6.3f%%", trace_name, software ? (flaky ? "sw, NACKs" : "software") : "hardware",
+           conversions, overflows, 100 * error_total / (conversions - overflows));
+    if (software) {
+        printf("  %3u range changes costing %3u conversions", engine.get_range_changes(), engine.get_settling_conversions());
+        if (flaky) printf(", %u writes retried", engine.get_failed_writes());
+        if (mismatches) printf("  FAILED: engine range differs from the sensor's %u times", mismatches);
+    }
+    printf("\n");
+    return mismatches == 0;
+}
+
+int main() {
+    const char *names[] = {"step", "ramp", "flicker"};
+    const opt3002_light_source_t traces[] = {step_trace, ramp_trace, flicker_trace};
+    bool passed = true;
+    for (size_t t = 0; t < 3; t++) {
+        run(names[t], traces[t], false);
+        passed = run(names[t], traces[t], true) and passed;
+        passed = run(names[t], traces[t], true, true) and passed;
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include <avr/sleep.h>
+
+#include "OPT3002.h"
+#include "OPT3002_static.h"
+#include "benchmark_ids.h"
+
+// Runs each driver call BENCHMARK_REPEATS times between GPIOR0 markers for
+// the simavr harness (extras/benchmarks/avr/simavr_opt3002.cpp), then halts.
+// Build with OPT3002_NO_FLOAT defined to measure the float-free build.
+
+OPT3002 sensor;
+OPT3002Static<OPT3002_RANGE_40K, OPT3002_CONV_TIME_100MS> static_sensor;
+
+// Inputs are volatile so the compiler cannot fold the conversions away
+volatile uint16_t word_input = 0x6456;
+volatile uint32_t nw_input = 123456;
+volatile uint32_t sink;
+#if !defined(OPT3002_NO_FLOAT)
+volatile float float_input = 123456.7f;
+volatile float float_sink;
+#endif
+
+#define MEASURE(id, statement)                           \
+    for (uint8_t i = 0; i < BENCHMARK_REPEATS; i++) {    \
+        GPIOR0 = id;                                     \
+        statement;                                       \
+        GPIOR0 = BENCHMARK_NONE;                         \
+    }
+
+void setup() {
+    Wire.begin();
+
+    opt3002_result_t result;
+    opt3002_power_t power;
+
+    MEASURE(BENCHMARK_EMPTY, );
+    MEASURE(BENCHMARK_BEGIN, sink = sensor.begin());
+
+    sensor.set_mode(OPT3002_MODE_CONTINUOUS);
+    sensor.set_conversion_time(OPT3002_CONV_TIME_100MS);
+    sensor.commit();
+    delay(110);
+
+    MEASURE(BENCHMARK_GET_OPTICAL_POWER, sink = sensor.get_optical_power());
+    MEASURE(BENCHMARK_GET_OPTICAL_POWER_PW, sensor.get_optical_power(power); sink = uint32_t(power.picowatts));
+    MEASURE(BENCHMARK_GET_CONFIG, sink = sensor.get_config().raw);
+    MEASURE(BENCHMARK_CHECK_COMMS, sink = sensor.check_comms());
+
+    result.raw = word_input;
+    MEASURE(BENCHMARK_SET_HIGH_LIMIT, sensor.set_high_limit(result));
+#if !defined(OPT3002_NO_FLOAT)
+    MEASURE(BENCHMARK_SET_HIGH_LIMIT_FLOAT, sensor.set_high_limit(float(float_input)));
+    MEASURE(BENCHMARK_CONVERT_TO_FLOAT, result.raw = word_input; float_sink = sensor.convert_measurement(result));
+    MEASURE(BENCHMARK_CONVERT_FROM_FLOAT, sink = sensor.convert_measurement(float(float_input)).raw);
+#endif
+    MEASURE(BENCHMARK_CONVERT_TO_NW, result.raw = word_input; sink = OPT3002::convert_to_nw(result));
+    MEASURE(BENCHMARK_CONVERT_TO_PW, result.raw = word_input; sink = uint32_t(OPT3002::convert_to_pw(result).picowatts));
+    MEASURE(BENCHMARK_ENCODE_NW, sink = OPT3002::encode_nw(nw_input).raw);
+
+    MEASURE(BENCHMARK_STATIC_BEGIN, sink = static_sensor.begin());
+    delay(110);
+    MEASURE(BENCHMARK_STATIC_GET_OPTICAL_POWER, sink = static_sensor.get_optical_power());
+
+    // Sleeping with interrupts off ends the simulation
+    cli();
+    sleep_enable();
+    sleep_cpu();
+}
+
+void loop() {}
@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+ * Markers shared by the AVR benchmark sketch and the simavr harness.
+ *
+ * The sketch writes a call's ID to GPIOR0 just before the call and 0 just
+ * after it; the harness timestamps both writes in CPU cycles and counts the
+ * TWI traffic in between. GPIOR0 is a plain register with single-cycle
+ * access, so the markers cost the same every time and are measured by the
+ * BENCHMARK_EMPTY pair.
+ */
+typedef enum OPT3002_BENCHMARK {
+    BENCHMARK_NONE = 0,
+    BENCHMARK_EMPTY,
+    BENCHMARK_BEGIN,
+    BENCHMARK_GET_OPTICAL_POWER,
+    BENCHMARK_GET_OPTICAL_POWER_PW,
+    BENCHMARK_GET_CONFIG,
+    BENCHMARK_CHECK_COMMS,
+    BENCHMARK_SET_HIGH_LIMIT,
+    BENCHMARK_SET_HIGH_LIMIT_FLOAT,
+    BENCHMARK_CONVERT_TO_FLOAT,
+    BENCHMARK_CONVERT_FROM_FLOAT,
+    BENCHMARK_CONVERT_TO_NW,
+    BENCHMARK_CONVERT_TO_PW,
+    BENCHMARK_ENCODE_NW,
+    BENCHMARK_STATIC_BEGIN,
+    BENCHMARK_STATIC_GET_OPTICAL_POWER,
+    BENCHMARK_COUNT
+} opt3002_benchmark_t;
+
+// Number of times the sketch makes each call
+const uint8_t BENCHMARK_REPEATS = 8;
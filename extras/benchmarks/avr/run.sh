@@ -0,0 +1,89 @@
+#!/bin/sh
+# AVR benchmarks: flash/RAM of the examples and cycles per driver call.
+#
+# Needs arduino-cli with the arduino:avr core (which provides avr-gcc and
+# avr-size), and simavr with its headers (libsimavr-dev or a source build).
+# Run from anywhere:
+#   extras/benchmarks/avr/run.sh
+#
+# Environment:
+#   FQBN          board to build for (default arduino:avr:uno)
+#   MCU, F_CPU    MCU name and clock for simavr (default atmega328p, 16000000)
+#   BUILD         scratch directory (default /tmp/opt3002_avr)
+#   SIMAVR_CFLAGS, SIMAVR_LIBS   override pkg-config for simavr
+#
+# Unmeasured: this script and the simavr harness were written without an AVR
+# toolchain or simavr to hand and have never been run. No cycle, flash or RAM
+# figures have been recorded for this target, and none are quoted anywhere in
+# the library. Record the first run's output here once it has been made.
+set -e
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$HERE/../../.." && pwd)
+FQBN=${FQBN:-arduino:avr:uno}
+MCU=${MCU:-atmega328p}
+F_CPU=${F_CPU:-16000000}
+BUILD=${BUILD:-/tmp/opt3002_avr}
+SIMAVR_CFLAGS=${SIMAVR_CFLAGS:-$(pkg-config --cflags simavr 2>/dev/null || true)}
+SIMAVR_LIBS=${SIMAVR_LIBS:-$(pkg-config --libs simavr 2>/dev/null || echo "-lsimavr -lelf")}
+AVR_SIZE=${AVR_SIZE:-$(command -v avr-size || find "$HOME/.arduino15/packages/arduino/tools/avr-gcc" -name avr-size -type f 2>/dev/null | head -n 1)}
+
+rm -rf "$BUILD"
+mkdir -p "$BUILD/sketches" "$BUILD/out"
+
+# Copy a sketch into its own folder together with the library sources, so it
+# builds without installing the library. $1: .ino file, $2: sketch name
+stage() {
+    mkdir -p "$BUILD/sketches/$2"
+    cp "$1" "$BUILD/sketches/$2/$2.ino"
+    cp "$ROOT"/src/*.h "$ROOT"/src/*.cpp "$BUILD/sketches/$2/"
+    cp "$(dirname "$1")"/*.h "$BUILD/sketches/$2/" 2>/dev/null || true
+}
+
+# Build a staged sketch. $1: sketch name, $2: output name, $3: extra C++ flags
+build() {
+    arduino-cli compile --fqbn "$FQBN" --build-path "$BUILD/out/$2" \
+        --build-property "compiler.cpp.extra_flags=$3" "$BUILD/sketches/$1" >/dev/null
+}
+
+# Print "flash ram" in bytes for a build
+sizes() {
+    "$AVR_SIZE" -A "$BUILD/out/$1/$1.ino.elf" | awk '$1 == ".text" || $1 == ".data" { flash += $2 } $1 == ".data" || $1 == ".bss" { ram += $2 } END { print flash, ram }'
+}
+
+stage "$HERE/wire_baseline/wire_baseline.ino" wire_baseline
+build wire_baseline wire_baseline ""
+set -- $(sizes wire_baseline)
+BASE_FLASH=$1
+BASE_RAM=$2
+
+echo "Footprint on $FQBN, relative to Wire alone ($BASE_FLASH B flash, $BASE_RAM B RAM)"
+printf "%-28s %8s %8s\n" "sketch" "flash" "RAM"
+for example in "$ROOT"/examples/*.ino; do
+    name=$(basename "$example" .ino)
+    stage "$example" "$name"
+    build "$name" "$name" ""
+    set -- $(sizes "$name")
+    printf "%-28s %+8d %+8d\n" "$name" $(($1 - BASE_FLASH)) $(($2 - BASE_RAM))
+done
+
+stage "$HERE/avr_benchmark/avr_benchmark.ino" avr_benchmark
+build avr_benchmark avr_benchmark ""
+mkdir -p "$BUILD/sketches/avr_benchmark_no_float"
+cp "$BUILD"/sketches/avr_benchmark/*.h "$BUILD"/sketches/avr_benchmark/*.cpp "$BUILD/sketches/avr_benchmark_no_float/"
+cp "$BUILD/sketches/avr_benchmark/avr_benchmark.ino" "$BUILD/sketches/avr_benchmark_no_float/avr_benchmark_no_float.ino"
+build avr_benchmark_no_float avr_benchmark_no_float "-DOPT3002_NO_FLOAT"
+for name in avr_benchmark avr_benchmark_no_float; do
+    set -- $(sizes "$name")
+    printf "%-28s %+8d %+8d\n" "$name" $(($1 - BASE_FLASH)) $(($2 - BASE_RAM))
+done
+
+g++ -std=c++11 -O2 -I"$ROOT/src" -I"$HERE" $SIMAVR_CFLAGS "$HERE/simavr_opt3002.cpp" \
+    "$ROOT/src/OPT3002.cpp" "$ROOT/src/OPT3002_transport.cpp" "$ROOT/src/OPT3002_clock.cpp" "$ROOT/src/OPT3002_simulator.cpp" \
+    $SIMAVR_LIBS -o "$BUILD/simavr_opt3002"
+
+for name in avr_benchmark avr_benchmark_no_float; do
+    echo
+    echo "$name:"
+    "$BUILD/simavr_opt3002" "$BUILD/out/$name/$name.ino.elf" "$MCU" "$F_CPU"
+done
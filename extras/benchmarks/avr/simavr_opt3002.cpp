@@ -0,0 +1,243 @@
+/**
+ * simavr harness: runs the AVR benchmark sketch against a simulated OPT3002.
+ *
+ * Built and run by run.sh in this directory. Usage:
+ *   simavr_opt3002 firmware.elf [mcu] [frequency_hz]
+ *
+ * The OPT3002Simulator from the library is attached to the MCU's TWI
+ * peripheral at address 0x44 and kept in step with the simulated CPU clock,
+ * so conversions complete on time and bus waits in Wire cost what they would
+ * on hardware. The sketch brackets every call with writes to GPIOR0 (see
+ * avr_benchmark/benchmark_ids.h); the harness reports the CPU cycles between
+ * the markers, less the cost of an empty marker pair, and the TWI traffic
+ * each call generated.
+ *
+ * Unmeasured: this harness has not been built or run yet (see run.sh), so it
+ * has produced no figures.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <simavr/avr_twi.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/sim_time.h>
+
+#include "OPT3002_simulator.h"
+#include "avr_benchmark/benchmark_ids.h"
+
+static const char *const BENCHMARK_NAMES[BENCHMARK_COUNT] = {
+    "",
+    "(empty marker pair)",
+    "begin",
+    "get_optical_power",
+    "get_optical_power(pW)",
+    "get_config",
+    "check_comms",
+    "set_high_limit(result)",
+    "set_high_limit(float)",
+    "convert_measurement(result)",
+    "convert_measurement(float)",
+    "convert_to_nw",
+    "convert_to_pw",
+    "encode_nw",
+    "OPT3002Static::begin",
+    "OPT3002Static::get_optical_power",
+};
+
+// GPIOR0 in data space on the ATmega48/88/168/328 family
+static const avr_io_addr_t GPIOR0_ADDRESS = 0x3E;
+
+// Give up if the sketch has not halted after this much simulated time
+static const uint64_t TIMEOUT_NS = 30000000000ULL;
+
+typedef struct {
+    uint32_t calls;
+    uint64_t cycles;
+    uint64_t min_cycles;
+    uint64_t max_cycles;
+    uint32_t transactions;
+    uint32_t bytes;
+} benchmark_stats_t;
+
+/**
+ * Adapter between simavr's TWI messages and OPT3002Simulator.
+ * simavr delivers a transaction byte by byte; writes are collected and handed
+ * to the simulator at the stop or repeated start, reads are fetched from it
+ * as a whole register when the read is addressed.
+ */
+class TwiSensor {
+   public:
+    TwiSensor(avr_t *avr, OPT3002Simulator &sensor)
+        : transactions(0), bytes(0), _avr(avr), _sensor(&sensor), _selected(false), _reading(false), _length(0), _read_index(0) {
+        static const char *names[2] = {"8>opt3002.out", "32<opt3002.in"};
+        _irq = avr_alloc_irq(&avr->irq_pool, 0, 2, names);
+        avr_irq_register_notify(_irq + TWI_IRQ_OUTPUT, on_message, this);
+
+        uint32_t twi = AVR_IOCTL_TWI_GETIRQ(0);
+        avr_connect_irq(_irq + TWI_IRQ_INPUT, avr_io_getirq(avr, twi, TWI_IRQ_INPUT));
+        avr_connect_irq(avr_io_getirq(avr, twi, TWI_IRQ_OUTPUT), _irq + TWI_IRQ_OUTPUT);
+    }
+
+    // TWI traffic addressed to the sensor
+    uint32_t transactions;
+    uint32_t bytes;
+
+   private:
+    avr_t *_avr;
+    avr_irq_t *_irq;
+    OPT3002Simulator *_sensor;
+    bool _selected;
+    bool _reading;
+    uint8_t _buffer[8];
+    uint8_t _length;
+    uint8_t _read_data[2];
+    uint8_t _read_index;
+
+    void acknowledge(uint8_t address) { avr_raise_irq(_irq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, address, 1)); }
+
+    void flush_write() {
+        if (_selected and not _reading and _length) _sensor->handle_write(_buffer, _length);
+        _length = 0;
+    }
+
+    static void on_message(avr_irq_t *, uint32_t value, void *param) {
+        TwiSensor *self = (TwiSensor *)param;
+        avr_twi_msg_irq_t message;
+        message.u.v = value;
+        self->handle(message.u.twi.msg, message.u.twi.addr, message.u.twi.data);
+    }
+
+    void handle(uint8_t condition, uint8_t address, uint8_t data) {
+        _sensor->advance_to(avr_cycles_to_nsec(_avr, _avr->cycle));
+
+        if (condition & TWI_COND_STOP) {
+            flush_write();
+            _selected = false;
+        }
+
+        if (condition & TWI_COND_START) {
+            flush_write();
+            _selected = (address >> 1) == _sensor->get_address();
+            if (not _selected) return;
+
+            transactions++;
+            bytes++;
+            _reading = address & 1;
+            if (_reading) {
+                _sensor->handle_read(_read_data, sizeof(_read_data));
+                _read_index = 0;
+            }
+            acknowledge(address);
+            return;
+        }
+
+        if (not _selected) return;
+
+        if (condition & TWI_COND_WRITE) {
+            if (_length < sizeof(_buffer)) _buffer[_length++] = data;
+            bytes++;
+            acknowledge(address);
+        }
+
+        if (condition & TWI_COND_READ) {
+            uint8_t byte = _read_data[_read_index & 1];
+            _read_index++;
+            bytes++;
+            avr_raise_irq(_irq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_READ, address, byte));
+        }
+    }
+};
+
+typedef struct {
+    TwiSensor *twi;
+    uint8_t current;
+    uint64_t start_cycle;
+    uint32_t start_transactions;
+    uint32_t start_bytes;
+    benchmark_stats_t stats[BENCHMARK_COUNT];
+} marker_state_t;
+
+static void on_marker(avr_t *avr, avr_io_addr_t address, uint8_t value, void *param) {
+    marker_state_t *state = (marker_state_t *)param;
+    avr->data[address] = value;
+
+    if (value != BENCHMARK_NONE) {
+        state->current = value < BENCHMARK_COUNT ? value : BENCHMARK_NONE;
+        state->start_cycle = avr->cycle;
+        state->start_transactions = state->twi->transactions;
+        state->start_bytes = state->twi->bytes;
+        return;
+    }
+    if (state->current == BENCHMARK_NONE) return;
+
+    benchmark_stats_t &stats = state->stats[state->current];
+    uint64_t cycles = avr->cycle - state->start_cycle;
+    if (stats.calls == 0 or cycles < stats.min_cycles) stats.min_cycles = cycles;
+    if (cycles > stats.max_cycles) stats.max_cycles = cycles;
+    stats.calls++;
+    stats.cycles += cycles;
+    stats.transactions += state->twi->transactions - state->start_transactions;
+    stats.bytes += state->twi->bytes - state->start_bytes;
+    state->current = BENCHMARK_NONE;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s firmware.elf [mcu] [frequency_hz]\n", argv[0]);
+        return 2;
+    }
+    const char *mcu = argc > 2 ? argv[2] : "atmega328p";
+    uint32_t frequency = argc > 3 ? strtoul(argv[3], NULL, 0) : 16000000UL;
+
+    elf_firmware_t firmware = {};
+    if (elf_read_firmware(argv[1], &firmware) != 0) {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 2;
+    }
+
+    avr_t *avr = avr_make_mcu_by_name(mcu);
+    if (avr == NULL) {
+        fprintf(stderr, "unknown MCU %s\n", mcu);
+        return 2;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, &firmware);
+    // Arduino builds do not record the clock in the ELF
+    avr->frequency = frequency;
+
+    static OPT3002Simulator sensor;
+    sensor.set_optical_power(12345.0f);
+    TwiSensor twi(avr, sensor);
+
+    static marker_state_t state = {};
+    state.twi = &twi;
+    avr_register_io_write(avr, GPIOR0_ADDRESS, on_marker, &state);
+
+    int cpu_state = cpu_Running;
+    while (cpu_state != cpu_Done and cpu_state != cpu_Crashed) {
+        cpu_state = avr_run(avr);
+        if (avr_cycles_to_nsec(avr, avr->cycle) > TIMEOUT_NS) break;
+    }
+    if (cpu_state != cpu_Done) {
+        fprintf(stderr, "sketch did not halt cleanly (state %d)\n", cpu_state);
+        return 1;
+    }
+
+    const benchmark_stats_t &empty = state.stats[BENCHMARK_EMPTY];
+    uint64_t overhead = empty.calls ? empty.min_cycles : 0;
+
+    printf("%s at %.1f MHz, marker overhead %llu cycles\n", mcu, frequency / 1e6, (unsigned long long)overhead);
+    printf("%-34s %10s %10s %10s %9s %8s %8s\n", "call", "cycles", "min", "max", "us", "txn", "bytes");
+    for (int id = BENCHMARK_BEGIN; id < BENCHMARK_COUNT; id++) {
+        const benchmark_stats_t &stats = state.stats[id];
+        if (stats.calls == 0) continue;
+
+        double cycles = double(stats.cycles) / stats.calls - overhead;
+        printf("%-34s %10.0f %10llu %10llu %9.1f %8.2f %8.2f\n", BENCHMARK_NAMES[id], cycles, (unsigned long long)(stats.min_cycles - overhead),
+               (unsigned long long)(stats.max_cycles - overhead), cycles * 1e6 / frequency, double(stats.transactions) / stats.calls,
+               double(stats.bytes) / stats.calls);
+    }
+    return 0;
+}
@@ -0,0 +1,17 @@
+#include <Wire.h>
+
+// Size baseline: the Arduino core and Wire doing one register read, without
+// the driver. The flash and RAM of each example are reported relative to this.
+
+volatile uint16_t sink;
+
+void setup() {
+    Wire.begin();
+    Wire.beginTransmission(0x44);
+    Wire.write(0x00);
+    Wire.endTransmission();
+    Wire.requestFrom(0x44, 2);
+    sink = uint16_t(Wire.read()) << 8 | Wire.read();
+}
+
+void loop() {}
@@ -0,0 +1,150 @@
+/**
+ * Host benchmark: bulk conversion of raw result words.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Isrc extras/benchmarks/bulk_benchmark.cpp src/OPT3002*.cpp -o bulk_benchmark
+ *   ./bulk_benchmark
+ *
+ * Every kernel the processor supports is first checked against the
+ * single-word conversions of OPT3002 for all 65536 words, starting at an odd
+ * address so the unaligned loads and the scalar tail are covered. The exit
+ * status is non-zero on any difference (floats are compared bit for bit).
+ *
+ * Throughput is then measured for each output type and kernel, with a
+ * per-word call to the OPT3002 conversion as the reference, once on a span
+ * that stays in cache and once on one that streams from memory. GB/s counts
+ * the raw words read (2 bytes each).
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "OPT3002_bulk.h"
+
+static const size_t CACHED_WORDS = 16 * 1024;
+static const size_t STREAMED_WORDS = 16 * 1024 * 1024;
+static const double MIN_SECONDS = 0.2;
+
+static OPT3002MemoryTransport transport;
+static OPT3002 sensor(transport);
+
+static const opt3002_decode_kernel_t KERNELS[] = {OPT3002_DECODE_SCALAR, OPT3002_DECODE_SSE2, OPT3002_DECODE_AVX2};
+
+static std::vector<uint16_t> words;
+static std::vector<float> floats;
+static std::vector<uint32_t> tenths;
+static std::vector<uint64_t> picowatts;
+static volatile uint64_t sink;
+
+static bool verify(opt3002_decode_kernel_t kernel) {
+    const size_t offset = 1;
+    const size_t count = 65536;
+    std::vector<uint16_t> input(count + offset);
+    for (size_t i = 0; i < count; i++) input[i + offset] = uint16_t(i);
+
+    std::vector<float> float_output(count + offset);
+    std::vector<uint32_t> tenths_output(count + offset);
+    std::vector<uint64_t> pw_output(count + offset);
+    opt3002_decode_set_kernel(kernel);
+    opt3002_decode_float(&input[offset], &float_output[offset], count);
+    opt3002_decode_nw_x10(&input[offset], &tenths_output[offset], count);
+    size_t saturated = opt3002_decode_pw(&input[offset], &pw_output[offset], count);
+
+    size_t errors = 0;
+    size_t expected_saturated = 0;
+    for (size_t i = offset; i < count + offset; i++) {
+        opt3002_result_t result;
+        result.raw = input[i];
+        float expected_float = sensor.convert_measurement(result);
+        opt3002_power_t power = OPT3002::convert_to_pw(result);
+        expected_saturated += power.saturated;
+
+        errors += memcmp(&float_output[i], &expected_float, sizeof(float)) != 0;
+        errors += tenths_output[i] != OPT3002::convert_to_nw_x10(result);
+        errors += pw_output[i] != power.picowatts;
+    }
+    errors += saturated != expected_saturated;
+    printf("%-8s %zu words: %s\n", opt3002_decode_kernel_name(kernel), count, errors ? "MISMATCH" : "bit-exact");
+    return errors == 0;
+}
+
+// Repeat a pass over count words until MIN_SECONDS have gone by; returns GB/s of input
+template <typename pass_t>
+static double measure(size_t count, pass_t pass) {
+    pass();
+    size_t passes = 0;
+    double seconds = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (seconds < MIN_SECONDS) {
+        pass();
+        passes++;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return passes * count * sizeof(uint16_t) / seconds / 1e9;
+}
+
+static void report(size_t count) {
+    printf("\n%zu words (%zu KiB in):\n", count, count * sizeof(uint16_t) / 1024);
+    printf("%-12s %10s %10s %10s\n", "kernel", "float", "nW x10", "pW");
+
+    double per_word[3];
+    per_word[0] = measure(count, [count]() {
+        for (size_t i = 0; i < count; i++) {
+            opt3002_result_t result;
+            result.raw = words[i];
+            floats[i] = sensor.convert_measurement(result);
+        }
+        sink = sink + floats[count / 2];
+    });
+    per_word[1] = measure(count, [count]() {
+        for (size_t i = 0; i < count; i++) {
+            opt3002_result_t result;
+            result.raw = words[i];
+            tenths[i] = OPT3002::convert_to_nw_x10(result);
+        }
+        sink = sink + tenths[count / 2];
+    });
+    per_word[2] = measure(count, [count]() {
+        for (size_t i = 0; i < count; i++) {
+            opt3002_result_t result;
+            result.raw = words[i];
+            picowatts[i] = OPT3002::convert_to_pw(result).picowatts;
+        }
+        sink = sink + picowatts[count / 2];
+    });
+    printf("%-12s %7.2f GB/s %5.2f GB/s %5.2f GB/s\n", "per-word", per_word[0], per_word[1], per_word[2]);
+
+    for (size_t k = 0; k < sizeof(KERNELS) / sizeof(KERNELS[0]); k++) {
+        if (not opt3002_decode_set_kernel(KERNELS[k])) continue;
+        double to_float = measure(count, [count]() { opt3002_decode_float(words.data(), floats.data(), count); });
+        double to_tenths = measure(count, [count]() { opt3002_decode_nw_x10(words.data(), tenths.data(), count); });
+        double to_pw = measure(count, [count]() { sink = sink + opt3002_decode_pw(words.data(), picowatts.data(), count); });
+        printf("%-12s %7.2f GB/s %5.2f GB/s %5.2f GB/s\n", opt3002_decode_kernel_name(KERNELS[k]), to_float, to_tenths, to_pw);
+    }
+}
+
+int main() {
+    printf("default kernel: %s\n\n", opt3002_decode_kernel_name(opt3002_decode_get_kernel()));
+
+    bool exact = true;
+    for (size_t k = 0; k < sizeof(KERNELS) / sizeof(KERNELS[0]); k++) {
+        if (opt3002_decode_set_kernel(KERNELS[k])) exact = verify(KERNELS[k]) and exact;
+    }
+
+    // Valid words with every exponent, in no particular order
+    words.resize(STREAMED_WORDS);
+    floats.resize(STREAMED_WORDS);
+    tenths.resize(STREAMED_WORDS);
+    picowatts.resize(STREAMED_WORDS);
+    uint32_t state = 1;
+    for (size_t i = 0; i < STREAMED_WORDS; i++) {
+        state = state * 1664525u + 1013904223u;
+        words[i] = opt3002_result_encode((state >> 28) % 12, (state >> 8) & 0x0FFF);
+    }
+
+    report(CACHED_WORDS);
+    report(STREAMED_WORDS);
+    return exact ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/**
+ * Simulator benchmark: bits per sample of the packet compression.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Isrc extras/benchmarks/compress_benchmark.cpp src/OPT3002*.cpp -o compress_benchmark
+ *   ./compress_benchmark [days]
+ *
+ * A simulated sensor under OPT3002DaylightTrace runs auto-range continuous
+ * conversions, read by OPT3002Bus, for clear, broken and overcast skies at
+ * both conversion times. Samples are packed with OPT3002SampleEncoder into
+ * packets of a few radio payload sizes, and every packet is decoded again
+ * and compared with what went in; the exit status is non-zero on any
+ * difference.
+ *
+ * Bits per sample include the packet headers and the padding of the last
+ * byte. For comparison, a plain (u32 timestamp, u16 word) record is 48 bits.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include "OPT3002_bus.h"
+#include "OPT3002_compress.h"
+#include "OPT3002_simulator.h"
+
+static const size_t PACKET_SIZES[] = {51, 222, 1024};
+static const size_t PACKET_SIZE_COUNT = sizeof(PACKET_SIZES) / sizeof(PACKET_SIZES[0]);
+
+static void on_sample(const opt3002_sample_t &sample, void *context) { ((std::vector<opt3002_sample_t> *)context)->push_back(sample); }
+
+static std::vector<opt3002_sample_t> record_trace(float cloud_cover, opt3002_conv_time_t conversion_time, double days) {
+    OPT3002DaylightTrace daylight(2.0e6f, cloud_cover);
+    OPT3002Simulator sensor;
+    sensor.set_light_source(OPT3002DaylightTrace::source, &daylight);
+    sensor.set_noise(2.0f);
+    OPT3002SimulatedBus bus;
+    bus.attach(sensor);
+
+    OPT3002Bus manager(bus, bus);
+    manager.begin();
+    manager.start(conversion_time);
+
+    std::vector<opt3002_sample_t> samples;
+    uint64_t run_ns = uint64_t(days * 86400e9);
+    while (bus.get_time_ns() < run_ns) {
+        manager.service(on_sample, &samples);
+        bus.sleep_us(manager.time_until_due());
+    }
+    return samples;
+}
+
+// Decode a packet and compare it with the samples it was made from
+static bool check_packet(const uint8_t *packet, size_t length, const opt3002_sample_t *samples, uint16_t count) {
+    OPT3002SampleDecoder decoder(packet, length);
+    if (decoder.get_count() != count) return false;
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t timestamp_us;
+        opt3002_result_t result;
+        if (not decoder.next(timestamp_us, result)) return false;
+        if (timestamp_us != samples[i].timestamp_us or result.raw != samples[i].result.raw) return false;
+    }
+    uint32_t timestamp_us;
+    opt3002_result_t result;
+    return not decoder.next(timestamp_us, result);
+}
+
+typedef struct {
+    size_t packets;
+    size_t bytes;
+    bool exact;
+} packing_t;
+
+static packing_t pack(const std::vector<opt3002_sample_t> &samples, size_t packet_size) {
+    std::vector<uint8_t> packet(packet_size);
+    OPT3002SampleEncoder encoder(packet.data(), packet_size);
+    packing_t packing = {0, 0, true};
+
+    size_t first = 0;
+    for (size_t i = 0; i <= samples.size(); i++) {
+        if (i < samples.size() and encoder.add(samples[i])) continue;
+
+        size_t length = encoder.finish();
+        packing.packets++;
+        packing.bytes += length;
+        packing.exact = check_packet(packet.data(), length, &samples[first], encoder.get_count()) and packing.exact;
+
+        first = i;
+        encoder.reset();
+        if (i < samples.size() and not encoder.add(samples[i])) packing.exact = false;
+    }
+    return packing;
+}
+
+int main(int argc, char **argv) {
+    double days = argc > 1 ? atof(argv[1]) : 1.0;
+    const float covers[] = {0.0f, 0.5f, 0.9f};
+    const char *cover_names[] = {"clear", "broken", "overcast"};
+    const opt3002_conv_time_t times[] = {OPT3002_CONV_TIME_100MS, OPT3002_CONV_TIME_800MS};
+
+    printf("%.2f day(s) per trace; bits/sample (samples per packet)\n\n", days);
+    printf("%-10s %6s %9s", "sky", "conv", "samples");
+    for (size_t p = 0; p < PACKET_SIZE_COUNT; p++) printf("   %12zu B", PACKET_SIZES[p]);
+    printf("\n");
+
+    bool exact = true;
+    for (size_t c = 0; c < 3; c++) {
+        for (size_t t = 0; t < 2; t++) {
+            std::vector<opt3002_sample_t> samples = record_trace(covers[c], times[t], days);
+            printf("%-10s %6s %9zu", cover_names[c], times[t] == OPT3002_CONV_TIME_100MS ? "100ms" : "800ms", samples.size());
+            for (size_t p = 0; p < PACKET_SIZE_COUNT; p++) {
+                packing_t packing = pack(samples, PACKET_SIZES[p]);
+                exact = exact and packing.exact;
+                printf("   %5.2f (%5.0f)", packing.bytes * 8.0 / samples.size(), double(samples.size()) / packing.packets);
+            }
+            printf("\n");
+        }
+    }
+    printf("\nround trip: %s\n", exact ? "exact" : "MISMATCH");
+    return exact ? 0 : 1;
+}
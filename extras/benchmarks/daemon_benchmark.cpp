@@ -0,0 +1,147 @@
+/**
+ * Simulator benchmark: OPT3002Daemon throughput and sampling jitter.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -pthread -Isrc extras/benchmarks/daemon_benchmark.cpp src/OPT3002*.cpp -o daemon_benchmark
+ *   ./daemon_benchmark [seconds_per_step]
+ *
+ * Each bus carries four simulated sensors running 100ms continuous
+ * conversions. The simulated buses are paced to the wall clock: virtual time
+ * follows CLOCK_MONOTONIC, and a transaction blocks the calling thread for
+ * as long as it would occupy a 100 kHz bus, the way a read on i2c-dev does.
+ *
+ * For 1 to 16 buses the benchmark reports samples per second (ideally 40 per
+ * bus) and the jitter of each sensor's sampling interval, i.e. how far the
+ * time between consecutive samples strays from the 100ms period.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "OPT3002_daemon.h"
+#include "OPT3002_simulator.h"
+
+static const uint8_t SENSORS_PER_BUS = 4;
+static const uint32_t PERIOD_US = 100000;
+
+static uint64_t wall_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return uint64_t(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+// Simulated bus whose virtual time follows the wall clock
+class RealTimeBus : public OPT3002Transport, public OPT3002Clock {
+   public:
+    RealTimeBus() {
+        for (uint8_t i = 0; i < SENSORS_PER_BUS; i++) {
+            _sensors[i] = OPT3002Simulator(OPT3002_DEFAULT_ADDRESS + i);
+            _sensors[i].set_optical_power(500.0f * (i + 1));
+            _bus.attach(_sensors[i]);
+        }
+        _bus.advance_to(wall_ns());
+    }
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length) {
+        catch_up();
+        bool result = _bus.write(device_address, data, length);
+        wait_for_bus();
+        return result;
+    }
+
+    bool read(uint8_t device_address, uint8_t *data, size_t length) {
+        catch_up();
+        bool result = _bus.read(device_address, data, length);
+        wait_for_bus();
+        return result;
+    }
+
+    uint32_t now_us() { return _clock.now_us(); }
+    void sleep_us(uint32_t duration_us) { _clock.sleep_us(duration_us); }
+
+   private:
+    OPT3002SimulatedBus _bus;
+    OPT3002Simulator _sensors[SENSORS_PER_BUS];
+    OPT3002LinuxClock _clock;
+
+    void catch_up() {
+        uint64_t now = wall_ns();
+        if (now > _bus.get_time_ns()) _bus.advance_to(now);
+    }
+
+    // Block until the wall clock reaches the end of the transaction
+    void wait_for_bus() {
+        uint64_t now = wall_ns();
+        if (_bus.get_time_ns() > now) _clock.sleep_us(uint32_t((_bus.get_time_ns() - now + 999) / 1000));
+    }
+};
+
+static double percentile(std::vector<uint32_t> &values, double fraction) {
+    if (values.empty()) return 0;
+    size_t index = size_t(fraction * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static void run(uint8_t buses, double seconds) {
+    std::vector<RealTimeBus *> transports;
+    OPT3002Daemon daemon;
+    for (uint8_t i = 0; i < buses; i++) {
+        transports.push_back(new RealTimeBus());
+        daemon.add_bus(*transports.back(), *transports.back());
+    }
+
+    uint8_t sensors = daemon.start(OPT3002_CONV_TIME_100MS);
+
+    // Last sample time of each sensor, indexed by bus and address offset
+    std::vector<uint32_t> last_us(buses * SENSORS_PER_BUS, 0);
+    std::vector<bool> seen(buses * SENSORS_PER_BUS, false);
+    std::vector<uint32_t> jitter_us;
+    uint32_t samples = 0;
+
+    // Skip the first period while the workers settle
+    uint64_t start = wall_ns() + PERIOD_US * 1000ULL;
+    uint64_t end = start + uint64_t(seconds * 1e9);
+    uint64_t now;
+    while ((now = wall_ns()) < end) {
+        opt3002_sample_t sample;
+        uint8_t bus;
+        if (not daemon.pop(sample, bus)) {
+            struct timespec pause = {0, 1000000};
+            nanosleep(&pause, NULL);
+            continue;
+        }
+        if (now < start) continue;
+
+        size_t index = bus * SENSORS_PER_BUS + (sample.address - OPT3002_DEFAULT_ADDRESS);
+        if (seen[index]) {
+            int32_t interval = int32_t(sample.timestamp_us - last_us[index]);
+            jitter_us.push_back(uint32_t(abs(interval - int32_t(PERIOD_US))));
+        }
+        seen[index] = true;
+        last_us[index] = sample.timestamp_us;
+        samples++;
+    }
+    daemon.stop();
+
+    uint32_t overruns = 0;
+    for (uint8_t i = 0; i < buses; i++) overruns += daemon.get_overruns(i);
+
+    double rate = samples / seconds;
+    printf("%5u %8u %12.1f %12.1f %10.0f %10.0f %10.0f %9u\n", buses, sensors, rate, rate / buses, percentile(jitter_us, 0.5),
+           percentile(jitter_us, 0.99), percentile(jitter_us, 1.0), overruns);
+
+    for (size_t i = 0; i < transports.size(); i++) delete transports[i];
+}
+
+int main(int argc, char **argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+
+    printf("4 sensors per bus, 100ms continuous conversions, %.1fs per step\n\n", seconds);
+    printf("%5s %8s %12s %12s %10s %10s %10s %9s\n", "buses", "sensors", "samples/s", "per bus", "p50 us", "p99 us", "max us", "overruns");
+    for (uint8_t buses = 1; buses <= OPT3002Daemon::MAX_BUSES; buses *= 2) run(buses, seconds);
+    return 0;
+}
@@ -0,0 +1,171 @@
+/**
+ * Host benchmark: cost of the driver's hot paths.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Isrc extras/benchmarks/driver_benchmark.cpp src/OPT3002*.cpp -o driver_benchmark
+ *   ./driver_benchmark                        # table
+ *   ./driver_benchmark --csv > baseline.csv   # record a baseline
+ *   ./driver_benchmark --baseline baseline.csv
+ *
+ * Each call runs against OPT3002MemoryTransport, whose counters give the I2C
+ * transactions and bytes on the wire (address byte included) per call. The
+ * figures are for repeated calls in steady state, i.e. with the register
+ * pointer cache already holding the register the call reads.
+ *
+ * Every call has a fixed bus budget below; the exit status is non-zero if
+ * one is exceeded. With --baseline, a call also fails if it is more than
+ * NS_TOLERANCE slower than the baseline, or uses more transactions or bytes.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "OPT3002.h"
+
+static const uint32_t ITERATIONS = 200000;
+static const int REPEATS = 7;
+static const double NS_TOLERANCE = 1.25;
+
+static OPT3002MemoryTransport transport;
+static OPT3002 sensor(transport);
+
+static volatile uint32_t sink;
+static volatile float float_sink;
+static uint32_t input_index;
+
+// A spread of result words and light levels so the conversions see every exponent
+static uint16_t next_word() { return uint16_t((input_index++ * 0x9E37u) & 0xBFFF); }
+static float next_power() { return float((input_index++ * 2654435761u) >> 8) * 0.7f; }
+
+typedef void (*benchmark_call_t)();
+
+static void call_get_optical_power() { sink = sensor.get_optical_power(); }
+static void call_get_config() { sink = sensor.get_config().raw; }
+static void call_set_high_limit() { sensor.set_high_limit(next_power()); }
+static void call_convert_to_float() {
+    opt3002_result_t result;
+    result.raw = next_word();
+    float_sink = sensor.convert_measurement(result);
+}
+static void call_convert_from_float() { sink = sensor.convert_measurement(next_power()).raw; }
+static void call_check_comms() { sink = sensor.check_comms(); }
+
+typedef struct {
+    const char *name;
+    benchmark_call_t call;
+    uint32_t max_transactions;  // Bus budget per call
+    uint32_t max_bytes;
+} benchmark_case_t;
+
+static const benchmark_case_t CASES[] = {
+    {"get_optical_power", call_get_optical_power, 1, 3},
+    {"get_config", call_get_config, 1, 3},
+    {"set_high_limit(float)", call_set_high_limit, 1, 4},
+    {"convert_measurement(result)", call_convert_to_float, 0, 0},
+    {"convert_measurement(float)", call_convert_from_float, 0, 0},
+    {"check_comms", call_check_comms, 1, 3},
+};
+static const size_t CASE_COUNT = sizeof(CASES) / sizeof(CASES[0]);
+
+typedef struct {
+    double ns;
+    double transactions;
+    double bytes;
+} benchmark_result_t;
+
+static benchmark_result_t run(const benchmark_case_t &test) {
+    // Warm the pointer cache and the instruction cache
+    for (int i = 0; i < 16; i++) test.call();
+
+    double best = 1e30;
+    transport.reset_counters();
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < ITERATIONS; i++) test.call();
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, elapsed / ITERATIONS);
+    }
+
+    benchmark_result_t result;
+    result.ns = best;
+    result.transactions = double(transport.get_transactions()) / (double(ITERATIONS) * REPEATS);
+    result.bytes = double(transport.get_bytes()) / (double(ITERATIONS) * REPEATS);
+    return result;
+}
+
+// Look a call up in a CSV written by --csv; false if it is not there
+static bool find_baseline(FILE *file, const char *name, benchmark_result_t &baseline) {
+    char line[256];
+    rewind(file);
+    while (fgets(line, sizeof(line), file)) {
+        char *comma = strchr(line, ',');
+        if (comma == NULL) continue;
+        *comma = '\0';
+        if (strcmp(line, name) != 0) continue;
+        return sscanf(comma + 1, "%lf,%lf,%lf", &baseline.ns, &baseline.transactions, &baseline.bytes) == 3;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    bool csv = false;
+    FILE *baseline_file = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (strcmp(argv[i], "--baseline") == 0 and i + 1 < argc) {
+            baseline_file = fopen(argv[++i], "r");
+            if (baseline_file == NULL) {
+                fprintf(stderr, "cannot open baseline %s\n", argv[i]);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "usage: %s [--csv] [--baseline FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (not sensor.begin()) {
+        fprintf(stderr, "sensor did not answer\n");
+        return 2;
+    }
+
+    if (csv) {
+        printf("call,ns_per_call,transactions_per_call,bytes_per_call\n");
+    } else {
+        printf("%-28s %10s %8s %8s\n", "call", "ns/call", "txn/call", "B/call");
+    }
+
+    int failures = 0;
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+        const benchmark_case_t &test = CASES[i];
+        benchmark_result_t result = run(test);
+
+        const char *verdict = "";
+        if (result.transactions > test.max_transactions or result.bytes > test.max_bytes) verdict = "  OVER BUS BUDGET";
+
+        benchmark_result_t baseline;
+        if (baseline_file != NULL and *verdict == '\0') {
+            if (not find_baseline(baseline_file, test.name, baseline)) {
+                verdict = "  (not in baseline)";
+            } else if (result.transactions > baseline.transactions or result.bytes > baseline.bytes) {
+                verdict = "  MORE BUS TRAFFIC THAN BASELINE";
+            } else if (result.ns > baseline.ns * NS_TOLERANCE) {
+                verdict = "  SLOWER THAN BASELINE";
+            }
+        }
+        if (strstr(verdict, "BASELINE") != NULL or strstr(verdict, "BUDGET") != NULL) failures++;
+
+        if (csv) {
+            printf("%s,%.2f,%.2f,%.2f\n", test.name, result.ns, result.transactions, result.bytes);
+        } else {
+            printf("%-28s %10.2f %8.2f %8.2f%s\n", test.name, result.ns, result.transactions, result.bytes, verdict);
+        }
+    }
+
+    if (baseline_file != NULL) fclose(baseline_file);
+    if (failures) fprintf(stderr, "%d call(s) failed the gate\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * Host benchmark: the original loop encoder against the CLZ encoder.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Isrc extras/benchmarks/encoder_benchmark.cpp src/OPT3002*.cpp -o encoder_benchmark
+ *   ./encoder_benchmark
+ *
+ * The integer conversions (convert_to_nw_x10, convert_to_nw and
+ * convert_to_pw) are first checked against exact 64-bit arithmetic for all
+ * 65536 result words; the exit status is non-zero on any difference.
+ *
+ * Both encoders are then run over the full input range (0.1 nW/cm^2 to beyond
+ * full scale, log-spaced) and timed. Accuracy is reported as the number of
+ * inputs that do not encode to the nearest representable value (or to full
+ * scale when out of range).
+ */
+#include <math.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <vector>
+
+#include "OPT3002.h"
+
+// The encoder as originally shipped, kept for comparison
+static opt3002_result_t loop_encoder(float input) {
+    uint8_t exponent = 0;
+    uint16_t fractional = input / 1.2;
+    while (fractional >= (1 << 12) and exponent < (1 << 4)) {
+        fractional /= 2;
+        exponent++;
+    }
+    // As the 4- and 12-bit fields did, keep the low bits of each
+    opt3002_result_t output;
+    output.raw = opt3002_result_encode(exponent, fractional);
+    return output;
+}
+
+static double decode(opt3002_result_t result) {
+    return opt3002_result_mantissa(result.raw) * 1.2 * double(1 << opt3002_result_exponent(result.raw));
+}
+
+static const double FULL_SCALE = 4095 * 1.2 * 2048;
+
+// True if the encoding is within half a step (plus 1 pW of input rounding) of
+// the input, or clamped correctly
+static bool is_nearest(float input, opt3002_result_t result) {
+    if (input >= FULL_SCALE) return result.raw == 0xBFFF;
+    uint8_t exponent = opt3002_result_exponent(result.raw);
+    double step = 1.2 * double(1 << exponent);
+    return exponent <= 11 and fabs(decode(result) - input) <= step / 2 + 0.001;
+}
+
+// Compare the integer conversions with exact arithmetic for every result word
+static bool check_conversions() {
+    size_t wrong = 0;
+    for (uint32_t word = 0; word <= 0xFFFF; word++) {
+        opt3002_result_t result;
+        result.raw = word;
+        uint64_t mantissa = opt3002_result_mantissa(word);
+        uint8_t exponent = opt3002_result_exponent(word);
+        uint64_t tenths = mantissa * 12 << exponent;
+
+        bool saturated = exponent > 11 or (exponent == 11 and mantissa == 0x0FFF);
+        uint64_t picowatts = saturated ? uint64_t(0x0FFF) * 1200 << 11 : mantissa * 1200 << exponent;
+        opt3002_power_t power = OPT3002::convert_to_pw(result);
+
+        wrong += OPT3002::convert_to_nw_x10(result) != tenths;
+        wrong += OPT3002::convert_to_nw(result) != tenths / 10;
+        wrong += power.picowatts != picowatts or power.saturated != saturated;
+    }
+    printf("integer conversions, 65536 words: %zu mismatches\n", wrong);
+    return wrong == 0;
+}
+
+template <typename Encoder>
+static void run(const char *name, const std::vector<float> &inputs, Encoder encoder) {
+    volatile uint16_t sink = 0;
+    const int rounds = 20;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (float input : inputs) sink = encoder(input).raw;
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    (void)sink;
+
+    size_t wrong = 0;
+    for (float input : inputs) wrong += not is_nearest(input, encoder(input));
+    printf("%-12s %8.2f ns/call   %zu/%zu not nearest\n", name, elapsed / (rounds * inputs.size()), wrong, inputs.size());
+}
+
+int main() {
+    bool exact = check_conversions();
+
+    std::vector<float> inputs;
+    for (double value = 0.1; value < 4.0e7; value *= 1.0001) inputs.push_back(float(value));
+    printf("%zu inputs from 0.1 to 4e7 nW/cm^2\n", inputs.size());
+
+    run("loop", inputs, loop_encoder);
+    static OPT3002MemoryTransport transport;
+    static OPT3002 sensor(transport);
+    run("clz (float)", inputs, [](float input) { return sensor.convert_measurement(input); });
+    run("clz (pW)", inputs, [](float input) { return OPT3002::encode_pw(uint64_t(double(input) * 1000 + 0.5)); });
+    return exact ? 0 : 1;
+}
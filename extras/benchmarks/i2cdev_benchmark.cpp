@@ -0,0 +1,183 @@
+/**
+ * Simulator benchmark: syscalls per sample on Linux i2c-dev.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Isrc extras/benchmarks/i2cdev_benchmark.cpp src/OPT3002*.cpp -o i2cdev_benchmark
+ *   ./i2cdev_benchmark
+ *
+ * Four simulated sensors run 100ms continuous conversions for 60s of virtual
+ * time and are read in three ways:
+ *  - read()/write() with I2C_SLAVE, as OPT3002LinuxTransport does, under
+ *    OPT3002Bus::service() (CONFIG poll, then RESULT)
+ *  - OPT3002I2cDevTransport under OPT3002Bus::service(), where every pointer
+ *    change is a combined I2C_RDWR
+ *  - OPT3002I2cDevTransport::read_results(), one batched I2C_RDWR per period
+ * The kernel is replaced by SimulatedI2cDev, and the read()/write()
+ * path by a wrapper that counts the calls OPT3002LinuxTransport would make.
+ * Batched results are checked against the simulators' RESULT registers.
+ */
+#include <errno.h>
+#include <linux/i2c.h>
+#include <stdio.h>
+
+#include "OPT3002_bus.h"
+#include "OPT3002_i2cdev.h"
+#include "OPT3002_simulator.h"
+
+static const uint8_t SENSORS = 4;
+static const uint64_t RUN_NS = 60000000000ULL;
+static const uint32_t PERIOD_US = 100000;
+
+/**
+ * Stand-in for an i2c-dev node that carries I2C_RDWR messages to simulated
+ * sensors, stopping at the first message that is not acknowledged. A message
+ * addressed to a device that is not attached fails the whole call, as a NACK
+ * does on a real adapter.
+ */
+class SimulatedI2cDev : public OPT3002I2cDevTransport {
+   public:
+    SimulatedI2cDev(OPT3002SimulatedBus &bus) : _bus(&bus) {}
+
+   protected:
+    bool submit(struct i2c_msg *messages, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            struct i2c_msg &message = messages[i];
+            bool acknowledged;
+            if (message.flags & I2C_M_RD) {
+                acknowledged = _bus->read(message.addr, message.buf, message.len);
+            } else {
+                acknowledged = _bus->write(message.addr, message.buf, message.len);
+            }
+            if (not acknowledged) {
+                errno = ENXIO;
+                return false;
+            }
+        }
+        return true;
+    }
+
+   private:
+    OPT3002SimulatedBus *_bus;
+};
+
+// Counts the syscalls of OPT3002LinuxTransport: one I2C_SLAVE ioctl per
+// address change, one read() or write() per transaction
+class LegacyCountingTransport : public OPT3002Transport {
+   public:
+    LegacyCountingTransport(OPT3002SimulatedBus &bus) : syscalls(0), _bus(&bus), _slave_address(0xFF) {}
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length) {
+        select(device_address);
+        syscalls++;
+        return _bus->write(device_address, data, length);
+    }
+
+    bool read(uint8_t device_address, uint8_t *data, size_t length) {
+        select(device_address);
+        syscalls++;
+        return _bus->read(device_address, data, length);
+    }
+
+    uint32_t syscalls;
+
+   private:
+    OPT3002SimulatedBus *_bus;
+    uint8_t _slave_address;
+
+    void select(uint8_t device_address) {
+        if (device_address == _slave_address) return;
+        _slave_address = device_address;
+        syscalls++;
+    }
+};
+
+typedef struct {
+    OPT3002SimulatedBus bus;
+    OPT3002Simulator sensors[SENSORS];
+} rig_t;
+
+static void setup_rig(rig_t &rig) {
+    for (uint8_t i = 0; i < SENSORS; i++) {
+        rig.sensors[i] = OPT3002Simulator(OPT3002_DEFAULT_ADDRESS + i);
+        rig.sensors[i].set_optical_power(1000.0f * (i + 1));
+        rig.sensors[i].set_noise(5.0f, i + 1);
+        rig.bus.attach(rig.sensors[i]);
+    }
+}
+
+static void count_sample(const opt3002_sample_t &, void *context) { (*(uint32_t *)context)++; }
+
+// Run OPT3002Bus::service() to the end of the run; returns samples delivered
+static uint32_t run_service(rig_t &rig, OPT3002Bus &manager) {
+    uint32_t samples = 0;
+    while (rig.bus.get_time_ns() < RUN_NS) {
+        manager.service(count_sample, &samples);
+        rig.bus.sleep_us(manager.time_until_due());
+    }
+    return samples;
+}
+
+int main() {
+    printf("%u sensors, 100ms continuous, %.0fs of virtual time\n\n", SENSORS, RUN_NS * 1e-9);
+    printf("%-34s %8s %10s %16s\n", "path", "samples", "syscalls", "syscalls/sample");
+
+    {
+        static rig_t rig;
+        setup_rig(rig);
+        LegacyCountingTransport transport(rig.bus);
+        OPT3002Bus manager(transport, rig.bus);
+        manager.begin();
+        manager.start(OPT3002_CONV_TIME_100MS);
+        transport.syscalls = 0;
+
+        uint32_t samples = run_service(rig, manager);
+        printf("%-34s %8u %10u %16.2f\n", "read()/write() + service()", samples, transport.syscalls, double(transport.syscalls) / samples);
+    }
+
+    {
+        static rig_t rig;
+        setup_rig(rig);
+        SimulatedI2cDev transport(rig.bus);
+        OPT3002Bus manager(transport, rig.bus);
+        manager.begin();
+        manager.start(OPT3002_CONV_TIME_100MS);
+        transport.reset_counters();
+
+        uint32_t samples = run_service(rig, manager);
+        printf("%-34s %8u %10u %16.2f\n", "I2C_RDWR + service()", samples, transport.get_syscalls(), double(transport.get_syscalls()) / samples);
+    }
+
+    static rig_t rig;
+    setup_rig(rig);
+    SimulatedI2cDev transport(rig.bus);
+    OPT3002 devices[SENSORS] = {OPT3002(transport), OPT3002(transport), OPT3002(transport), OPT3002(transport)};
+    OPT3002 *sensors[SENSORS];
+    for (uint8_t i = 0; i < SENSORS; i++) {
+        sensors[i] = &devices[i];
+        devices[i].begin(OPT3002_DEFAULT_ADDRESS + i);
+        devices[i].set_mode(OPT3002_MODE_CONTINUOUS);
+        devices[i].set_conversion_time(OPT3002_CONV_TIME_100MS);
+        devices[i].commit();
+    }
+    transport.reset_counters();
+
+    uint32_t samples = 0;
+    uint32_t mismatches = 0;
+    uint32_t next_us = rig.bus.now_us() + PERIOD_US;
+    while (rig.bus.get_time_ns() < RUN_NS) {
+        rig.bus.sleep_us(next_us - rig.bus.now_us());
+        next_us += PERIOD_US;
+
+        opt3002_result_t results[SENSORS];
+        if (not transport.read_results(sensors, SENSORS, results)) continue;
+        for (uint8_t i = 0; i < SENSORS; i++) mismatches += results[i].raw != rig.sensors[i].get_register(0x00);
+        samples += SENSORS;
+    }
+    printf("%-34s %8u %10u %16.2f\n", "I2C_RDWR batched read_results()", samples, transport.get_syscalls(), double(transport.get_syscalls()) / samples);
+
+    if (mismatches) {
+        printf("\n%u batched results differ from the sensors' RESULT registers\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
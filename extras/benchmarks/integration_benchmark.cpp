@@ -0,0 +1,132 @@
+/**
+ * Simulator benchmark: switching of the integration-time scheduler.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Isrc extras/benchmarks/integration_benchmark.cpp src/OPT3002*.cpp -o integration_benchmark
+ *   ./integration_benchmark
+ *
+ * OPT3002IntegrationScheduler chooses the conversion time for a simulated
+ * sensor with 20 nW/cm^2 rms noise, over 150s of light that is flat at
+ * 1 uW/cm^2 for 60s, rises tenfold over 30s and is flat again for 60s. The
+ * sensor converts continuously; the main loop checks CONFIG every 5ms and
+ * feeds each new result to the scheduler.
+ *
+ * The run is made on a clean bus, and again on one that NACKs every second
+ * CONFIG write, so that every other switch has to be retried.
+ *
+ * Printed: every switch, with its time and the scheduler's trend and noise
+ * estimates. Checked: three switches in all; long conversions at the end of
+ * each flat section and short ones at the end of the rise, both as reported
+ * and in the sensor's CONFIG; and after every update() with nothing left
+ * staged, the conversion time the scheduler reports is the sensor's. The
+ * exit status is non-zero if a check fails.
+ */
+#include <math.h>
+#include <stdio.h>
+
+#include "OPT3002_integration.h"
+#include "OPT3002_simulator.h"
+
+static const uint64_t NS_PER_S = 1000000000ULL;
+
+static float flat_ramp_flat(uint64_t time_ns, void *context) {
+    (void)context;
+    float seconds = float(time_ns / 1000000) * 1e-3f;
+    if (seconds < 60.0f) return 1000.0f;
+    if (seconds < 90.0f) return 1000.0f * powf(10.0f, (seconds - 60.0f) / 30.0f);
+    return 10000.0f;
+}
+
+/**
+ * The simulated bus, NACKing every nth CONFIG write (pointer and value).
+ * A period of 0 never fails.
+ */
+class ConfigFaultTransport : public OPT3002Transport {
+   public:
+    ConfigFaultTransport(OPT3002SimulatedBus &bus, uint32_t period) : _bus(&bus), _period(period), _writes(0), _failures(0) {}
+
+    uint32_t get_failures() const { return _failures; }
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length) {
+        if (_period and length == 3 and data[0] == 0x01 and ++_writes % _period == 0) {
+            _failures++;
+            return false;
+        }
+        return _bus->write(device_address, data, length);
+    }
+    bool read(uint8_t device_address, uint8_t *data, size_t length) { return _bus->read(device_address, data, length); }
+
+   private:
+    OPT3002SimulatedBus *_bus;
+    uint32_t _period;
+    uint32_t _writes;
+    uint32_t _failures;
+};
+
+static bool check(bool condition, const char *what) {
+    if (not condition) printf("    FAILED: %s\n", what);
+    return condition;
+}
+
+static bool run(bool flaky) {
+    OPT3002SimulatedBus bus;
+    OPT3002Simulator simulator;
+    simulator.set_light_source(flat_ramp_flat, NULL);
+    simulator.set_noise(20.0f);
+    bus.attach(simulator);
+
+    ConfigFaultTransport transport(bus, 0);
+    OPT3002 sensor(transport);
+    sensor.begin();
+    OPT3002IntegrationScheduler scheduler(sensor);
+    scheduler.begin(OPT3002_CONV_TIME_100MS);
+    sensor.set_mode(OPT3002_MODE_CONTINUOUS);
+    sensor.commit();
+    if (flaky) transport = ConfigFaultTransport(bus, 2);
+
+    // Conversion time in use at the checkpoints: end of the first flat, end of the rise, end of the second flat
+    const uint32_t checkpoints_s[] = {59, 88, 149};
+    const opt3002_conv_time_t expected[] = {OPT3002_CONV_TIME_800MS, OPT3002_CONV_TIME_100MS, OPT3002_CONV_TIME_800MS};
+    size_t checkpoint = 0;
+    bool passed = true;
+    uint32_t mismatches = 0;
+
+    printf("%s bus\n%8s %6s %14s %10s\n", flaky ? "flaky" : "clean", "time", "to", "trend ppm/s", "noise ppm");
+    uint32_t switches = 0;
+    while (bus.get_time_ns() < 150 * NS_PER_S) {
+        while (checkpoint < 3 and bus.get_time_ns() >= checkpoints_s[checkpoint] * NS_PER_S) {
+            bool expect_long = expected[checkpoint] == OPT3002_CONV_TIME_800MS;
+            passed &= check(scheduler.get_conversion_time() == expected[checkpoint], "reported conversion time at a checkpoint");
+            passed &= check(opt3002_config_conversion_time(simulator.get_register(0x01)) == expect_long, "sensor's conversion time at a checkpoint");
+            checkpoint++;
+        }
+
+        bus.sleep_us(5000);
+        opt3002_config_t flags;
+        if (not sensor.refresh_flags(flags) or not opt3002_config_flag(flags.raw, OPT3002_CONFIG_CONVERSION_READY)) continue;
+
+        opt3002_sample_t sample;
+        sample.timestamp_us = bus.now_us();
+        if (not sensor.get_result(sample.result)) continue;
+
+        scheduler.update(sample);
+        bool sensor_long = opt3002_config_conversion_time(simulator.get_register(0x01));
+        if (not sensor.is_config_dirty() and sensor_long != (scheduler.get_conversion_time() == OPT3002_CONV_TIME_800MS)) mismatches++;
+        if (scheduler.get_switches() != switches) {
+            switches = scheduler.get_switches();
+            printf("%7.1fs %6s %14u %10u\n", bus.get_time_ns() * 1e-9, scheduler.get_conversion_time() == OPT3002_CONV_TIME_100MS ? "100ms" : "800ms",
+                   scheduler.get_rate_ppm_per_s(), scheduler.get_noise_ppm());
+        }
+    }
+    passed &= check(checkpoint == 3, "every checkpoint reached");
+    passed &= check(switches == 3, "three switches");
+    passed &= check(mismatches == 0, "reported conversion time is the sensor's");
+    printf("%u switches in 150s, %u CONFIG writes NACKed: %s\n\n", switches, transport.get_failures(), passed ? "ok" : "FAILED");
+    return passed;
+}
+
+int main() {
+    bool passed = run(false);
+    passed = run(true) and passed;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+/**
+ * Simulator benchmark: interrupt-driven acquisition through an eventfd line.
+ *
+ * Build and run from the repository root (Linux only):
+ *   g++ -std=c++11 -O2 -Isrc extras/benchmarks/interrupt_benchmark.cpp src/OPT3002*.cpp -o interrupt_benchmark
+ *   ./interrupt_benchmark
+ *
+ * OPT3002InterruptReader runs a simulated sensor in end-of-conversion mode.
+ * The simulator's pin callback signals an OPT3002InterruptLine opened as an
+ * eventfd on each asserting edge of INT, and logs the RESULT word of the
+ * conversion that raised it. The light ramps up so that every conversion has
+ * its own result word.
+ *
+ * The main loop ticks every 100us. When the line is readable it consumes the
+ * edges and, after a pseudo-random latency, calls notify() and service(). The
+ * latency is anywhere from 0 to one conversion time less 2ms, so the main loop
+ * always answers an edge before the sensor overwrites the result, but at any
+ * point of the conversion in progress.
+ *
+ * Each conversion time is run with a clean bus, and again with every 7th
+ * CONFIG pointer write and every 11th RESULT pointer write NACKed. A failed
+ * service() stays pending, and the main loop calls it again on the next
+ * tick while is_pending().
+ *
+ * Checked: the samples delivered are exactly the logged conversions, each
+ * once and in order, and every conversion the simulator completed raised an
+ * edge. The exit status is non-zero if a check fails.
+ */
+#include <stdio.h>
+
+#include <vector>
+
+#include "OPT3002_async.h"
+#include "OPT3002_gpio.h"
+#include "OPT3002_simulator.h"
+
+static const uint32_t TICK_US = 100;
+
+/**
+ * The simulated bus, NACKing every nth pointer write to CONFIG and to RESULT.
+ * A period of 0 never fails.
+ */
+class FlakyTransport : public OPT3002Transport {
+   public:
+    FlakyTransport(OPT3002SimulatedBus &bus, uint32_t config_period, uint32_t result_period)
+        : _bus(&bus), _config_period(config_period), _result_period(result_period), _config_writes(0), _result_writes(0), _failures(0) {}
+
+    uint32_t get_failures() const { return _failures; }
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length) {
+        if (length == 1 and (fails(data[0], 0x01, _config_period, _config_writes) or fails(data[0], 0x00, _result_period, _result_writes))) {
+            _failures++;
+            return false;
+        }
+        return _bus->write(device_address, data, length);
+    }
+    bool read(uint8_t device_address, uint8_t *data, size_t length) { return _bus->read(device_address, data, length); }
+
+   private:
+    OPT3002SimulatedBus *_bus;
+    uint32_t _config_period;
+    uint32_t _result_period;
+    uint32_t _config_writes;
+    uint32_t _result_writes;
+    uint32_t _failures;
+
+    static bool fails(uint8_t pointer, uint8_t target, uint32_t period, uint32_t &count) {
+        if (pointer != target or period == 0) return false;
+        return ++count % period == 0;
+    }
+};
+
+// Light rising by 20 nW/cm^2 per second, i.e. at least 1.6 counts per conversion
+static float ramp(uint64_t time_ns, void *context) {
+    (void)context;
+    return 1000.0f + 20.0f * float(time_ns / 1000) * 1e-6f;
+}
+
+typedef struct {
+    OPT3002Simulator *simulator;
+    OPT3002InterruptLine *line;
+    std::vector<uint16_t> conversions;
+} edge_log_t;
+
+// Active-low INT: a falling edge is a completed conversion, whose word is in RESULT (0x00)
+static void on_pin(bool level, void *context) {
+    edge_log_t *log = (edge_log_t *)context;
+    if (level) return;
+    log->conversions.push_back(log->simulator->get_register(0x00));
+    log->line->signal();
+}
+
+static void on_sample(const opt3002_sample_t &sample, void *context) { ((std::vector<uint16_t> *)context)->push_back(sample.result.raw); }
+
+static bool run(opt3002_conv_time_t conversion_time, uint32_t conversions, bool flaky) {
+    uint32_t conversion_us = conversion_time == OPT3002_CONV_TIME_100MS ? 100000 : 800000;
+    uint32_t max_latency_us = conversion_us - 2000;
+
+    OPT3002SimulatedBus bus;
+    OPT3002Simulator simulator;
+    simulator.set_light_source(ramp, NULL);
+    bus.attach(simulator);
+
+    OPT3002InterruptLine line;
+    if (not line.open_eventfd()) {
+        printf("cannot open an eventfd\n");
+        return false;
+    }
+    edge_log_t log;
+    log.simulator = &simulator;
+    log.line = &line;
+    simulator.set_pin_callback(on_pin, &log);
+
+    FlakyTransport transport(bus, flaky ? 7 : 0, flaky ? 11 : 0);
+    OPT3002 sensor(transport);
+    sensor.begin();
+    OPT3002InterruptReader reader(sensor, bus);
+    std::vector<uint16_t> samples;
+    reader.set_callback(on_sample, &samples);
+    reader.begin(conversion_time, OPT3002_ACTIVE_LOW);
+
+    uint32_t random = 1;
+    uint32_t latency_total_us = 0;
+    // A reader that stalls is caught by the time limit rather than hanging
+    uint64_t limit_ns = uint64_t(conversions + 10) * conversion_us * 1000;
+    while (reader.get_samples() < conversions and bus.get_time_ns() < limit_ns) {
+        bus.sleep_us(TICK_US);
+        if (reader.is_pending()) reader.service();
+        if (not line.wait(0)) continue;
+        line.consume();
+
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        uint32_t latency_us = random % (max_latency_us + 1);
+        latency_total_us += latency_us;
+
+        bus.sleep_us(latency_us);
+        reader.notify();
+        reader.service();
+    }
+    reader.end();
+
+    bool exact = samples == log.conversions;
+    bool every_edge = log.conversions.size() == simulator.get_conversions();
+    printf("%-6s %-6s %11u %9u %9zu %9u %11u us   %s\n", conversion_time == OPT3002_CONV_TIME_100MS ? "100ms" : "800ms", flaky ? "flaky" : "clean",
+           simulator.get_conversions(), unsigned(log.conversions.size()), samples.size(), transport.get_failures(), latency_total_us / conversions,
+           exact and every_edge ? "ok" : "FAILED");
+    if (not every_edge) printf("    FAILED: a conversion raised no edge\n");
+    if (not exact) printf("    FAILED: samples differ from the conversions\n");
+    return exact and every_edge;
+}
+
+int main() {
+    printf("%-6s %-6s %11s %9s %9s %9s %14s\n", "conv", "bus", "conversions", "edges", "samples", "NACKs", "mean latency");
+    bool passed = true;
+    for (int flaky = 0; flaky < 2; flaky++) {
+        passed = run(OPT3002_CONV_TIME_100MS, 200, flaky) and passed;
+        passed = run(OPT3002_CONV_TIME_800MS, 50, flaky) and passed;
+    }
+    return passed ? 0 : 1;
+}
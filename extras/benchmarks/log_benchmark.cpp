@@ -0,0 +1,126 @@
+/**
+ * Simulator benchmark: size and decode speed of the binary sample log.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Isrc extras/benchmarks/log_benchmark.cpp src/OPT3002*.cpp -o log_benchmark
+ *   ./log_benchmark [days]
+ *
+ * One simulated sensor under OPT3002DaylightTrace runs auto-range 100ms
+ * continuous conversions, read by OPT3002Bus. Every sample goes to an
+ * OPT3002LogWriter writing a file, and is also sized as a 12-byte
+ * (u64 timestamp, float) record and as a CSV line. The file is then mapped
+ * with OPT3002LogReader and decoded in full; the decoded samples are checked
+ * against the originals, and a seek to mid-run is checked too.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#include "OPT3002_bus.h"
+#include "OPT3002_log.h"
+#include "OPT3002_simulator.h"
+
+static const char *LOG_PATH = "/tmp/opt3002_benchmark.log";
+
+static bool file_sink(const uint8_t *data, size_t length, void *context) { return fwrite(data, 1, length, (FILE *)context) == length; }
+
+typedef struct {
+    OPT3002LogWriter *writer;
+    std::vector<opt3002_sample_t> *samples;
+    size_t csv_bytes;
+} capture_t;
+
+static void on_sample(const opt3002_sample_t &sample, void *context) {
+    capture_t *capture = (capture_t *)context;
+    capture->writer->write(sample);
+    capture->samples->push_back(sample);
+
+    char line[48];
+    capture->csv_bytes += snprintf(line, sizeof(line), "%u,%.1f\n", sample.timestamp_us, OPT3002::convert_to_nw_x10(sample.result) / 10.0);
+}
+
+int main(int argc, char **argv) {
+    double days = argc > 1 ? atof(argv[1]) : 1.0;
+    uint64_t run_ns = uint64_t(days * 86400e9);
+
+    OPT3002DaylightTrace daylight(2.0e6f, 0.5f);
+    OPT3002Simulator sensor;
+    sensor.set_light_source(OPT3002DaylightTrace::source, &daylight);
+    sensor.set_noise(2.0f);
+    OPT3002SimulatedBus bus;
+    bus.attach(sensor);
+
+    OPT3002Bus manager(bus, bus);
+    manager.begin();
+    manager.start(OPT3002_CONV_TIME_100MS);
+
+    FILE *file = fopen(LOG_PATH, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "cannot create %s\n", LOG_PATH);
+        return 1;
+    }
+    OPT3002LogWriter writer(file_sink, file);
+    writer.begin();
+    writer.set_source(OPT3002_DEFAULT_ADDRESS, manager.get_device(0).get_shadow_config());
+
+    std::vector<opt3002_sample_t> samples;
+    capture_t capture = {&writer, &samples, 0};
+    while (bus.get_time_ns() < run_ns) {
+        manager.service(on_sample, &capture);
+        bus.sleep_us(manager.time_until_due());
+    }
+    writer.flush();
+    fclose(file);
+
+    size_t count = samples.size();
+    double log_bytes = writer.get_bytes_written();
+    printf("%.2f day(s) of 100ms samples: %zu samples\n\n", days, count);
+    printf("%-28s %12s %10s %8s\n", "format", "bytes", "B/sample", "ratio");
+    printf("%-28s %12.0f %10.2f %8.2f\n", "CSV (us,nW)", double(capture.csv_bytes), double(capture.csv_bytes) / count, capture.csv_bytes / log_bytes);
+    printf("%-28s %12.0f %10.2f %8.2f\n", "u64 timestamp + float", count * 12.0, 12.0, count * 12.0 / log_bytes);
+    printf("%-28s %12.0f %10.2f %8.2f\n", "OPT3002 log", log_bytes, log_bytes / count, 1.0);
+
+    OPT3002LogReader reader;
+    if (not reader.open(LOG_PATH)) {
+        fprintf(stderr, "cannot map %s\n", LOG_PATH);
+        return 1;
+    }
+
+    const int rounds = 10;
+    size_t decoded = 0;
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        reader.rewind();
+        opt3002_log_record_t record;
+        while (reader.next(record)) {
+            checksum += record.timestamp_us + record.result.raw;
+            decoded++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("\ndecode: %.1f M samples/s, %.0f MB/s of log (checksum %llx)\n", decoded / seconds / 1e6, rounds * log_bytes / seconds / 1e6,
+           (unsigned long long)checksum);
+
+    // Every sample must come back with its 64-bit timestamp and raw word
+    size_t mismatches = 0;
+    reader.rewind();
+    uint64_t base_us = samples.empty() ? 0 : samples[0].timestamp_us;
+    uint64_t time_us = base_us;
+    for (size_t i = 0; i < count; i++) {
+        if (i) time_us += uint32_t(samples[i].timestamp_us - samples[i - 1].timestamp_us);
+        opt3002_log_record_t record;
+        if (not reader.next(record) or record.timestamp_us != time_us or record.result.raw != samples[i].result.raw) mismatches++;
+    }
+
+    uint64_t target_us = base_us + uint64_t(days * 43200e6);
+    reader.seek(target_us);
+    opt3002_log_record_t record;
+    bool seek_ok = reader.next(record) and record.timestamp_us >= target_us and record.timestamp_us < target_us + 200000;
+    printf("round trip: %zu mismatches, seek to mid-run %s\n", mismatches, seek_ok ? "ok" : "FAILED");
+
+    remove(LOG_PATH);
+    return mismatches == 0 and seek_ok ? 0 : 1;
+}
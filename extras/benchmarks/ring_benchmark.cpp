@@ -0,0 +1,68 @@
+/**
+ * Host benchmark: two threads streaming samples through OPT3002SampleRing.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -pthread -Isrc extras/benchmarks/ring_benchmark.cpp -o ring_benchmark
+ *   ./ring_benchmark
+ *
+ * The producer pushes a numbered stream of samples, retrying whenever the
+ * ring is full (each failed attempt counts as an overrun); the consumer
+ * drains in batches and checks that every sample is exactly the next one
+ * in the stream. Reports throughput, full-ring retries and ordering errors.
+ */
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "OPT3002_ring.h"
+
+template <size_t Capacity>
+static void run(uint32_t total) {
+    static OPT3002SampleRing<Capacity, uint32_t> ring;
+    std::atomic<bool> done(false);
+    uint32_t received = 0;
+    uint32_t errors = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&]() {
+        opt3002_sample_t batch[64];
+        uint32_t expected = 0;
+        while (true) {
+            bool finished = done.load(std::memory_order_acquire);
+            size_t count = ring.drain(batch, 64);
+            for (size_t i = 0; i < count; i++) {
+                if (batch[i].timestamp_us != expected) errors++;
+                expected = batch[i].timestamp_us + 1;
+                if (batch[i].result.raw != uint16_t(batch[i].timestamp_us)) errors++;
+            }
+            received += count;
+            if (finished and count == 0) break;
+            if (count == 0) std::this_thread::yield();
+        }
+    });
+
+    opt3002_sample_t sample;
+    sample.address = 0x44;
+    for (uint32_t i = 0; i < total; i++) {
+        sample.timestamp_us = i;
+        sample.result.raw = uint16_t(i);
+        while (not ring.push(sample)) std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t overruns = ring.get_overruns();
+    printf("capacity %5zu: %6.1f M samples/s, %u/%u received, %u full-ring retries, %u ordering errors\n", Capacity,
+           total / seconds / 1e6, received, total, overruns, errors);
+}
+
+int main() {
+    const uint32_t total = 5000000;
+    run<16>(total);
+    run<256>(total);
+    run<4096>(total);
+    return 0;
+}
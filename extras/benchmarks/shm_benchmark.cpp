@@ -0,0 +1,240 @@
+/**
+ * Host benchmark: publish-to-observe latency of the shared-memory ring.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -pthread -Isrc extras/benchmarks/shm_benchmark.cpp src/OPT3002*.cpp -o shm_benchmark
+ *   ./shm_benchmark [readers] [samples] [stress samples]
+ *
+ * Latency: the parent process reads a simulated sensor through the driver
+ * and publishes one sample per millisecond with OPT3002SamplePublisher. Each
+ * reader is a separate process polling its own OPT3002SampleSubscriber; it
+ * timestamps every sample as it sees it and reports the delay since the
+ * publisher stamped it, plus any samples it missed. Readers yield the CPU
+ * when the ring is empty, so on a machine with fewer cores than readers the
+ * figures include scheduling delay.
+ *
+ * Stress: a thread publishes 2M samples (by default) into a 4-slot ring,
+ * yielding only every 16th sample, while another thread reads it, so the
+ * reader is lapped and slots are rewritten under its copies all the time.
+ * Checked: every sample received has the picowatts of its raw word and comes
+ * after the previous one, and received plus missed equals published.
+ *
+ * Replacement: a reader attached to a ring that is created again sees it
+ * retired, still reads the samples it held, and on reopening finds the next
+ * generation.
+ *
+ * The exit status is non-zero if a reader fails or a check fails.
+ */
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "OPT3002_shm.h"
+#include "OPT3002_simulator.h"
+
+static const char *RING_NAME = "opt3002_benchmark";
+static const uint8_t END_ADDRESS = 0;  // Address of the sample that ends the run
+static const uint8_t STRESS_ADDRESS = 0x44;
+
+static uint64_t monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return uint64_t(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+static int run_reader(int id, uint32_t samples) {
+    OPT3002SampleSubscriber subscriber;
+    if (not subscriber.open(RING_NAME)) {
+        fprintf(stderr, "reader %d: cannot open ring\n", id);
+        return 1;
+    }
+    subscriber.seek_oldest();
+
+    std::vector<uint32_t> latency_ns;
+    latency_ns.reserve(samples);
+    while (true) {
+        opt3002_shm_sample_t sample;
+        if (not subscriber.read(sample)) {
+            sched_yield();
+            continue;
+        }
+        uint64_t seen = monotonic_ns();
+        if (sample.address == END_ADDRESS) break;
+        latency_ns.push_back(uint32_t(seen - sample.timestamp_ns));
+    }
+
+    std::sort(latency_ns.begin(), latency_ns.end());
+    size_t count = latency_ns.size();
+    if (count == 0) return 1;
+    printf("reader %d: %zu samples, %llu missed, latency p50 %.2f us, p99 %.2f us, max %.2f us\n", id, count,
+           (unsigned long long)subscriber.get_missed(), latency_ns[count / 2] / 1e3, latency_ns[count * 99 / 100] / 1e3,
+           latency_ns[count - 1] / 1e3);
+    fflush(stdout);
+    return 0;
+}
+
+static bool check(bool condition, const char *what) {
+    if (not condition) printf("    FAILED: %s\n", what);
+    return condition;
+}
+
+// Result words of the stress run: every exponent and a spread of mantissas
+static opt3002_result_t stress_word(uint32_t index) {
+    opt3002_result_t result;
+    result.raw = uint16_t(index * 40503u);
+    return result;
+}
+
+static void stress_publisher(OPT3002SamplePublisher *publisher, uint32_t samples, bool *done) {
+    for (uint32_t i = 0; i < samples; i++) {
+        publisher->publish(STRESS_ADDRESS, stress_word(i));
+        // Hand over the CPU now and then, so a single core also interleaves the threads
+        if (i % 16 == 15) sched_yield();
+    }
+    __atomic_store_n(done, true, __ATOMIC_RELEASE);
+}
+
+static bool run_stress(uint32_t samples) {
+    OPT3002SamplePublisher publisher;
+    OPT3002SampleSubscriber subscriber;
+    if (not publisher.create(RING_NAME, 4) or not subscriber.open(RING_NAME)) {
+        fprintf(stderr, "cannot create the stress ring\n");
+        return false;
+    }
+
+    bool done = false;
+    std::thread writer(stress_publisher, &publisher, samples, &done);
+    uint64_t received = 0;
+    uint64_t torn = 0;
+    uint64_t out_of_order = 0;
+    uint64_t last_timestamp = 0;
+    while (true) {
+        // Read done before draining, so nothing published after the last read is left
+        bool finished = __atomic_load_n(&done, __ATOMIC_ACQUIRE);
+        opt3002_shm_sample_t sample;
+        bool any = false;
+        while (subscriber.read(sample)) {
+            any = true;
+            received++;
+            opt3002_result_t raw;
+            raw.raw = sample.raw;
+            if (sample.address != STRESS_ADDRESS or sample.picowatts != OPT3002::convert_to_pw(raw).picowatts) torn++;
+            if (sample.timestamp_ns < last_timestamp) out_of_order++;
+            last_timestamp = sample.timestamp_ns;
+        }
+        if (finished and not any) break;
+        if (not any) sched_yield();
+    }
+    writer.join();
+
+    uint64_t published = publisher.get_published();
+    bool passed = check(published == samples, "every sample published");
+    passed &= check(received > 0, "some samples received");
+    passed &= check(torn == 0, "picowatts match the raw word");
+    passed &= check(out_of_order == 0, "samples arrive in order");
+    passed &= check(received + subscriber.get_missed() == published, "received plus missed is published");
+    printf("stress: %llu published into 4 slots, %llu received, %llu missed, %llu torn: %s\n", (unsigned long long)published,
+           (unsigned long long)received, (unsigned long long)subscriber.get_missed(), (unsigned long long)torn, passed ? "ok" : "FAILED");
+    OPT3002SamplePublisher::unlink_ring(RING_NAME);
+    return passed;
+}
+
+static bool run_replacement() {
+    OPT3002SamplePublisher first;
+    OPT3002SampleSubscriber subscriber;
+    opt3002_result_t result = stress_word(1);
+    if (not first.create(RING_NAME, 16) or not subscriber.open(RING_NAME)) {
+        fprintf(stderr, "cannot create the ring to replace\n");
+        return false;
+    }
+    first.publish(STRESS_ADDRESS, result);
+    uint32_t generation = subscriber.get_generation();
+    bool passed = check(not subscriber.is_retired(), "a new ring is not retired");
+
+    OPT3002SamplePublisher second;
+    passed &= check(second.create(RING_NAME, 16), "the ring can be replaced");
+    second.publish(STRESS_ADDRESS, result);
+    second.publish(STRESS_ADDRESS, result);
+
+    opt3002_shm_sample_t sample;
+    passed &= check(subscriber.is_retired(), "the replaced ring is retired");
+    passed &= check(subscriber.read(sample) and sample.raw == result.raw, "the replaced ring still reads");
+    passed &= check(subscriber.open(RING_NAME) and subscriber.get_generation() == generation + 1, "reopening finds the next generation");
+    subscriber.seek_oldest();
+    passed &= check(subscriber.read(sample) and subscriber.read(sample) and not subscriber.read(sample), "the new ring reads");
+
+    OPT3002SamplePublisher::unlink_ring(RING_NAME);
+    passed &= check(subscriber.is_retired(), "an unlinked ring is retired");
+    subscriber.close();
+    subscriber.seek_latest();
+    subscriber.seek_oldest();
+    passed &= check(not subscriber.read(sample) and not subscriber.is_retired(), "a closed subscriber reads nothing");
+    printf("replacement: generation %u to %u: %s\n", generation, generation + 1, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+int main(int argc, char **argv) {
+    int readers = argc > 1 ? atoi(argv[1]) : 2;
+    uint32_t samples = argc > 2 ? strtoul(argv[2], NULL, 0) : 5000;
+    uint32_t stress_samples = argc > 3 ? strtoul(argv[3], NULL, 0) : 2000000;
+
+    OPT3002SamplePublisher publisher;
+    if (not publisher.create(RING_NAME, 4096)) {
+        fprintf(stderr, "cannot create ring\n");
+        return 1;
+    }
+
+    for (int id = 0; id < readers; id++) {
+        if (fork() == 0) _exit(run_reader(id, samples));
+    }
+
+    OPT3002SimulatedBus bus(0);
+    OPT3002Simulator device;
+    device.set_optical_power(12345.0f);
+    bus.attach(device);
+    OPT3002 sensor(bus);
+    sensor.begin();
+
+    // Let the readers attach before the first sample
+    struct timespec pause = {0, 100000000};
+    nanosleep(&pause, NULL);
+
+    printf("%d reader process(es), %u samples at 1 kHz\n", readers, samples);
+    uint64_t publish_ns = 0;
+    for (uint32_t i = 0; i < samples; i++) {
+        bus.advance(1000000);
+        uint64_t start = monotonic_ns();
+        publisher.publish(sensor);
+        publish_ns += monotonic_ns() - start;
+
+        struct timespec period = {0, 1000000};
+        nanosleep(&period, NULL);
+    }
+    opt3002_result_t end;
+    end.raw = 0;
+    publisher.publish(END_ADDRESS, end);
+    printf("publisher: %.1f ns per publish() including the simulated read\n", double(publish_ns) / samples);
+    fflush(stdout);
+
+    int failures = 0;
+    for (int id = 0; id < readers; id++) {
+        int status;
+        wait(&status);
+        failures += not WIFEXITED(status) or WEXITSTATUS(status) != 0;
+    }
+    publisher.close();
+    OPT3002SamplePublisher::unlink_ring(RING_NAME);
+
+    bool passed = failures == 0;
+    passed = run_stress(stress_samples) and passed;
+    passed = run_replacement() and passed;
+    OPT3002SamplePublisher::unlink_ring(RING_NAME);
+    return passed ? 0 : 1;
+}
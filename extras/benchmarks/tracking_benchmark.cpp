@@ -0,0 +1,118 @@
+/**
+ * Simulator benchmark: wakeups of the window tracker over an hour.
+ *
+ * Build and run from the repository root:
+ *   g++ -std=c++11 -O2 -Isrc extras/benchmarks/tracking_benchmark.cpp src/OPT3002*.cpp -o tracking_benchmark
+ *   ./tracking_benchmark
+ *
+ * OPT3002WindowTracker with its defaults (10% band, two faults, 800ms
+ * conversions) follows a simulated sensor for one hour of 20 uW/cm^2 light
+ * drifting by +-3% over the hour, with noise, and stepping up by 30% at the
+ * half hour. The simulator's pin callback calls notify() the way the INT pin
+ * interrupt handler would; the main loop sleeps in 100ms ticks and calls
+ * service().
+ *
+ * The run is made with every write answered, and again with the limit writes
+ * of the first re-centring failing. Reported: conversions, wakeups, limit
+ * writes and bus transactions. Checked: the host wakes no more than twice
+ * plus once per failed re-centring, get_limit_writes() counts exactly the
+ * limit writes the sensor accepted, and the last level reported is within
+ * the band of the light at the end of the hour. The exit status is non-zero
+ * if a check fails.
+ */
+#include <math.h>
+#include <stdio.h>
+
+#include "OPT3002_simulator.h"
+#include "OPT3002_tracking.h"
+
+static const uint64_t HOUR_NS = 3600ULL * 1000000000ULL;
+static const float LEVEL = 20000.0f;
+
+static float hour_of_light(uint64_t time_ns, void *context) {
+    (void)context;
+    float hours = float(time_ns / 1000000) * 1e-3f / 3600.0f;
+    float drift = 1.0f + 0.03f * sinf(2.0f * float(M_PI) * hours);
+    return LEVEL * drift * (time_ns < HOUR_NS / 2 ? 1.0f : 1.3f);
+}
+
+/**
+ * The simulated bus, refusing a number of LOW_LIMIT and HIGH_LIMIT writes
+ * and counting the ones that go through.
+ */
+class LimitFaultTransport : public OPT3002Transport {
+   public:
+    LimitFaultTransport(OPT3002SimulatedBus &bus) : _bus(&bus), _failures(0), _limit_writes(0) {}
+
+    void fail_limit_writes(uint32_t count) { _failures = count; }
+    uint32_t get_limit_writes() const { return _limit_writes; }
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length) {
+        bool limit = length == 3 and (data[0] == 0x02 or data[0] == 0x03);
+        if (limit and _failures > 0) {
+            _failures--;
+            return false;
+        }
+        bool success = _bus->write(device_address, data, length);
+        if (limit and success) _limit_writes++;
+        return success;
+    }
+    bool read(uint8_t device_address, uint8_t *data, size_t length) { return _bus->read(device_address, data, length); }
+
+   private:
+    OPT3002SimulatedBus *_bus;
+    uint32_t _failures;
+    uint32_t _limit_writes;
+};
+
+// Active-low INT: a falling edge is the tracker's interrupt
+static void on_pin(bool level, void *context) {
+    if (not level) ((OPT3002WindowTracker *)context)->notify();
+}
+
+static bool check(bool condition, const char *what) {
+    if (not condition) printf("    FAILED: %s\n", what);
+    return condition;
+}
+
+static bool run(uint32_t failed_limit_writes) {
+    OPT3002SimulatedBus bus;
+    OPT3002Simulator simulator;
+    simulator.set_light_source(hour_of_light, NULL);
+    simulator.set_noise(20.0f);
+    bus.attach(simulator);
+
+    LimitFaultTransport transport(bus);
+    OPT3002 sensor(transport);
+    sensor.begin();
+    OPT3002WindowTracker tracker(sensor, bus);
+    simulator.set_pin_callback(on_pin, &tracker);
+
+    bool passed = check(tracker.begin(), "begin() writes the limits");
+    transport.fail_limit_writes(failed_limit_writes);
+    bus.reset_counters();
+    while (bus.get_time_ns() < HOUR_NS) {
+        bus.sleep_us(100000);
+        tracker.service();
+    }
+
+    // A failed re-centring writes neither limit and is retried on the next wakeup
+    uint32_t failed_recentres = (failed_limit_writes + 1) / 2;
+    float last_level = OPT3002::convert_to_nw_x10(tracker.take().result) / 10.0f;
+    float final_light = LEVEL * 1.3f;
+    passed &= check(tracker.get_wakeups() <= 2 + failed_recentres, "at most two wakeups plus retries");
+    passed &= check(tracker.get_limit_writes() == transport.get_limit_writes(), "limit writes count the accepted writes");
+    passed &= check(fabsf(last_level - final_light) < final_light * 0.1f, "window follows the light");
+
+    printf("%-20s %11u %8u %8u %7u   %s\n", failed_limit_writes ? "first recentre fails" : "all writes answer", simulator.get_conversions(),
+           tracker.get_wakeups(), tracker.get_limit_writes(), bus.get_transactions(), passed ? "ok" : "FAILED");
+    return passed;
+}
+
+int main() {
+    printf("one hour at 20 uW/cm^2, 800ms conversions\n");
+    printf("%-20s %11s %8s %8s %7s\n", "case", "conversions", "wakeups", "limits", "trans");
+    bool passed = run(0);
+    passed = run(2) and passed;
+    return passed ? 0 : 1;
+}
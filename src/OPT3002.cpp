@@ -1,5 +1,19 @@
 #include "OPT3002.h"
 
+#include <string.h>
+
+#if defined(ARDUINO)
+static OPT3002WireTransport default_wire_transport;
+
+OPT3002::OPT3002() : _transport(&default_wire_transport), _device_address(OPT3002_DEFAULT_ADDRESS), _register_pointer(NO_POINTER), _config_dirty(false) {
+    _config.raw = OPT3002_CONFIG_RESET;
+}
+#endif
+
+OPT3002::OPT3002(OPT3002Transport &transport) : _transport(&transport), _device_address(OPT3002_DEFAULT_ADDRESS), _register_pointer(NO_POINTER), _config_dirty(false) {
+    _config.raw = OPT3002_CONFIG_RESET;
+}
+
 /**
  * Set the address of the sensor.
  * The address is set with hardware, depending on the configuration of the ADDR pin.
@@ -16,57 +30,74 @@ void OPT3002::set_address(uint8_t address) {
     address |= 0b1000100;
     address = address & 0b1000111;
     _device_address = address;
+    _register_pointer = NO_POINTER;
 }
 
 /**
  * Write a value to a register using I2C
  *
- * @param input: Byte to write to the register.
+ * @param value: Register word to write, sent most significant byte first.
  * @param address: Address of register to write to.
  * @return: Success/error result of the write.
  */
-bool OPT3002::write(uint8_t *input, opt3002_reg_t address) {
-    bool result = true;
-    Wire.beginTransmission(_device_address);
-    Wire.write(address);
-    Wire.write(input[1]);
-    Wire.write(input[0]);
-
-    if (Wire.endTransmission() != 0) {
-        result = false;
-    }
-    return result;
+bool OPT3002::write(uint16_t value, opt3002_reg_t address) {
+    _register_pointer = NO_POINTER;
+    uint8_t buffer[3] = {address};
+    opt3002_pack(value, buffer + 1);
+    return _transport->write(_device_address, buffer, sizeof(buffer));
 }
 
 /**
- * Read a specified number of bytes using the I2C bus.
- * @param output: The buffer in which to store the read values.
- * @param address: Register address to read (or starting address in burst reads)
- * @param length: Number of bytes to read.
+ * Read a register using the I2C bus.
+ * The pointer write is skipped when the sensor's pointer already holds the
+ * requested register; otherwise it goes out through write_read() so backends
+ * that support it can use a repeated start.
+ *
+ * @param value: Register word read, assembled from the most significant byte first.
+ * @param address: Register address to read.
  */
-bool OPT3002::read(uint8_t *output, opt3002_reg_t address) {
-    bool result = true;
-    Wire.beginTransmission(_device_address);
-    Wire.write(address);
-    if (Wire.endTransmission() != 0)
-        result = false;
+bool OPT3002::read(uint16_t &value, opt3002_reg_t address) {
+    uint8_t buffer[2];
+    bool success;
+    if (_register_pointer == address) {
+        success = _transport->read(_device_address, buffer, 2);
+    } else {
+        uint8_t pointer = address;
+        success = _transport->write_read(_device_address, &pointer, 1, buffer, 2);
+    }
 
-    else  // OK, all worked, keep going
-    {
-        Wire.requestFrom(_device_address, 2);
-        for (size_t i = 0; (i < 2) and Wire.available(); i++) {
-            uint8_t c = Wire.read();
-            output[1 - i] = c;
-        }
+    if (not success) {
+        _register_pointer = NO_POINTER;
+        return false;
     }
-    return result;
+    _register_pointer = address;
+
+    value = opt3002_unpack(buffer[0], buffer[1]);
+    return true;
 }
 
 /**
- *
+ * Write a full configuration to the sensor.
+ * The read-only flag bits are cleared before sending, and the shadow copy
+ * takes the new writable fields.
  */
-void OPT3002::write(opt3002_config_t config) { write((uint8_t *)&config, OPT3002_REGISTER::CONFIG); }
-void OPT3002::read(opt3002_config_t &config) { read((uint8_t *)&config, OPT3002_REGISTER::CONFIG); }
+void OPT3002::write(opt3002_config_t config) {
+    config.raw &= ~OPT3002_CONFIG_READ_ONLY;
+    _config.raw = (_config.raw & OPT3002_CONFIG_READ_ONLY) | config.raw;
+    _config_dirty = not write(config.raw, OPT3002_REGISTER::CONFIG);
+}
+
+/**
+ * Read the sensor's configuration.
+ * The shadow copy takes the flags; it takes the writable fields too unless
+ * there are staged changes that have not been committed.
+ */
+void OPT3002::read(opt3002_config_t &config) {
+    if (not read(config.raw, OPT3002_REGISTER::CONFIG)) return;
+
+    uint16_t keep = _config_dirty ? ~OPT3002_CONFIG_READ_ONLY : 0;
+    _config.raw = (_config.raw & keep) | (config.raw & ~keep);
+}
 
 /**
  *
@@ -77,13 +108,87 @@ opt3002_config_t OPT3002::get_config() {
     return current_config;
 }
 
+void OPT3002::stage_config(uint16_t raw) {
+    raw &= ~OPT3002_CONFIG_READ_ONLY;
+    if ((_config.raw & ~OPT3002_CONFIG_READ_ONLY) == raw) return;
+
+    _config.raw = (_config.raw & OPT3002_CONFIG_READ_ONLY) | raw;
+    _config_dirty = true;
+}
+
+void OPT3002::set_mode(opt3002_mode_t mode) { stage_config(opt3002_config_with(_config.raw, OPT3002_CONFIG_MODE_MASK, OPT3002_CONFIG_MODE_SHIFT, mode)); }
+
+void OPT3002::set_range(opt3002_range_t range) { stage_config(opt3002_config_with(_config.raw, OPT3002_CONFIG_RANGE_MASK, OPT3002_CONFIG_RANGE_SHIFT, range)); }
+
+void OPT3002::set_conversion_time(opt3002_conv_time_t conversion_time) { stage_config(opt3002_config_with(_config.raw, OPT3002_CONFIG_CONVERSION_TIME_MASK, OPT3002_CONFIG_CONVERSION_TIME_SHIFT, conversion_time)); }
+
+void OPT3002::set_interrupt_mode(opt3002_interrupt_mode_t interrupt_mode) { stage_config(opt3002_config_with_flag(_config.raw, OPT3002_CONFIG_LATCH, interrupt_mode == OPT_INT_LATCHED)); }
+
+void OPT3002::set_interrupt_polarity(opt3002_interrupt_polarity_t polarity) { stage_config(opt3002_config_with_flag(_config.raw, OPT3002_CONFIG_POLARITY, polarity == OPT3002_ACTIVE_HIGH)); }
+
+void OPT3002::set_fault_count(opt3002_fault_count_t fault_count) { stage_config(opt3002_config_with(_config.raw, OPT3002_CONFIG_FAULT_COUNT_MASK, 0, fault_count)); }
+
+void OPT3002::set_mask_exponent(bool enabled) { stage_config(opt3002_config_with_flag(_config.raw, OPT3002_CONFIG_MASK_EXPONENT, enabled)); }
+
+/**
+ * Send the staged configuration to the sensor in a single write.
+ * @return: True if nothing was staged or the write succeeded.
+ */
+bool OPT3002::commit() {
+    if (not _config_dirty) return true;
+
+    _config_dirty = not write(_config.raw & ~OPT3002_CONFIG_READ_ONLY, OPT3002_REGISTER::CONFIG);
+    return not _config_dirty;
+}
+
+/**
+ * Start a single-shot conversion.
+ * The write is always sent, since the sensor returns itself to shutdown
+ * after each single-shot conversion while the shadow copy still reads
+ * single-shot.
+ */
+bool OPT3002::trigger() {
+    set_mode(OPT3002_MODE_SINGLE_SHOT);
+    _config_dirty = true;
+    return commit();
+}
+
+/**
+ * Refresh the read-only flags of the shadow copy from the sensor.
+ * Note that reading CONFIG clears the conversion-ready flag and, in latched
+ * mode, the fault flags on the sensor. If the read fails, the shadow's
+ * conversion-ready flag is cleared so a stale flag is not acted on twice.
+ */
+opt3002_config_t OPT3002::refresh_flags() {
+    opt3002_config_t config;
+    refresh_flags(config);
+    return config;
+}
+
+/**
+ * As refresh_flags(), reporting whether CONFIG was read.
+ * @param config: The shadow copy after the refresh.
+ * @return: False if the read failed, in which case a latched interrupt has
+ *          not been acknowledged either.
+ */
+bool OPT3002::refresh_flags(opt3002_config_t &config) {
+    opt3002_config_t current;
+    bool success = read(current.raw, OPT3002_REGISTER::CONFIG);
+    if (success) {
+        _config.raw = (_config.raw & ~OPT3002_CONFIG_READ_ONLY) | (current.raw & OPT3002_CONFIG_READ_ONLY);
+    } else {
+        _config.raw = opt3002_config_with_flag(_config.raw, OPT3002_CONFIG_CONVERSION_READY, false);
+    }
+    config = _config;
+    return success;
+}
+
 /**
  * Check that things work // TODO - documentation
  */
 bool OPT3002::check_comms() {
-    uint8_t buffer[2];
-    read(buffer, OPT3002_REGISTER::MANUFACTURER_ID);
-    uint16_t manufacturer_id = uint16_t(buffer[1]) << 8 | buffer[0];
+    uint16_t manufacturer_id = 0;
+    read(manufacturer_id, OPT3002_REGISTER::MANUFACTURER_ID);
 
     // Make sure the manufacturer's ID matches the expected value ('TI')
     bool success = false;
@@ -98,28 +203,55 @@ bool OPT3002::check_comms() {
  */
 uint32_t OPT3002::get_optical_power() {
     opt3002_result_t result;
-    read((uint8_t *)&result, OPT3002_REGISTER::RESULT);
+    read(result.raw, OPT3002_REGISTER::RESULT);
+
+    return convert_to_nw(result);
+}
+
+/**
+ * Read the sensor's latest measurement at full resolution.
+ * @param power: Optical power in pW/cm^2 and the saturation flag.
+ * @return: False if the result register could not be read.
+ */
+bool OPT3002::get_optical_power(opt3002_power_t &power) {
+    opt3002_result_t result;
+    if (not read(result.raw, OPT3002_REGISTER::RESULT)) return false;
 
-    float optical_power = convert_measurement(result);
-    return (uint32_t)optical_power;
+    power = convert_to_pw(result);
+    return true;
 }
 
+/**
+ * Read the sensor's latest measurement without conversion.
+ * @return: False if the result register could not be read.
+ */
+bool OPT3002::get_result(opt3002_result_t &result) { return read(result.raw, OPT3002_REGISTER::RESULT); }
+
 bool OPT3002::begin(uint8_t address) {
     set_address(address);
-    return check_comms();
+    if (not check_comms()) return false;
+
+    // Bring the shadow configuration in line with the sensor
+    _config_dirty = false;
+    get_config();
+    return true;
 }
 
-void OPT3002::set_high_limit(opt3002_result_t high_limit) { write((uint8_t *)&high_limit, OPT3002_REGISTER::HIGH_LIMIT); }
-void OPT3002::set_high_limit(float high_limit) { set_high_limit(convert_measurement(high_limit)); }
+bool OPT3002::set_high_limit(opt3002_result_t high_limit) { return write(high_limit.raw, OPT3002_REGISTER::HIGH_LIMIT); }
+#if !defined(OPT3002_NO_FLOAT)
+bool OPT3002::set_high_limit(float high_limit) { return set_high_limit(convert_measurement(high_limit)); }
+#endif
 
 opt3002_result_t OPT3002::get_high_limit() {
     opt3002_result_t limit;
-    read((uint8_t *)&limit, OPT3002_REGISTER::HIGH_LIMIT);
+    read(limit.raw, OPT3002_REGISTER::HIGH_LIMIT);
     return limit;
 }
 
-void OPT3002::set_low_limit(opt3002_result_t low_limit) { write((uint8_t *)&low_limit, OPT3002_REGISTER::LOW_LIMIT); }
-void OPT3002::set_low_limit(float low_limit) { set_low_limit(convert_measurement(low_limit)); }
+bool OPT3002::set_low_limit(opt3002_result_t low_limit) { return write(low_limit.raw, OPT3002_REGISTER::LOW_LIMIT); }
+#if !defined(OPT3002_NO_FLOAT)
+bool OPT3002::set_low_limit(float low_limit) { return set_low_limit(convert_measurement(low_limit)); }
+#endif
 
 /**
  * Get the low limit level from the sensor.
@@ -127,28 +259,156 @@ void OPT3002::set_low_limit(float low_limit) { set_low_limit(convert_measurement
  */
 opt3002_result_t OPT3002::get_low_limit() {
     opt3002_result_t limit;
-    read((uint8_t *)&limit, OPT3002_REGISTER::LOW_LIMIT);
+    read(limit.raw, OPT3002_REGISTER::LOW_LIMIT);
     return limit;
 }
 
+/**
+ * Convert a result to optical power in units of 0.1 nW/cm^2.
+ * R * 2^E * 1.2 nW/cm^2 is exactly R * 12 * 2^E tenths, which needs only
+ * shifts and adds and fits in 32 bits for every exponent.
+ */
+uint32_t OPT3002::convert_to_nw_x10(opt3002_result_t input) {
+    uint32_t reading = opt3002_result_mantissa(input.raw);
+    return ((reading << 3) + (reading << 2)) << opt3002_result_exponent(input.raw);
+}
+
+/**
+ * Convert a result to whole nW/cm^2, truncating the fraction.
+ * Divides the exact tenths by 10 with the shift-and-add reciprocal from
+ * Hacker's Delight (divu10), so no hardware divide or multiply is needed.
+ */
+uint32_t OPT3002::convert_to_nw(opt3002_result_t input) {
+    uint32_t n = convert_to_nw_x10(input);
+    uint32_t q = (n >> 1) + (n >> 2);
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q >>= 3;
+    uint32_t r = n - (((q << 2) + q) << 1);
+    return q + (r > 9);
+}
+
+/**
+ * Convert a result to pW/cm^2.
+ * R * 1200 is formed with shifts and adds in 32 bits (it is below 2^23);
+ * only the final exponent shift needs 64 bits.
+ */
+opt3002_power_t OPT3002::convert_to_pw(opt3002_result_t input) {
+    const uint8_t top_exponent = 11;
+    const uint16_t full_scale = 0x0FFF;
+
+    opt3002_power_t output;
+    uint32_t reading = opt3002_result_mantissa(input.raw);
+    uint8_t exponent = opt3002_result_exponent(input.raw);
+    output.saturated = exponent > top_exponent or (exponent == top_exponent and reading == full_scale);
+    if (exponent > top_exponent) {
+        reading = full_scale;
+        exponent = top_exponent;
+    }
+
+    // 1200 = 1024 + 128 + 32 + 16
+    uint32_t scaled = (reading << 10) + (reading << 7) + (reading << 5) + (reading << 4);
+    output.picowatts = uint64_t(scaled) << exponent;
+    return output;
+}
+
+/**
+ * Enable or disable end-of-conversion interrupt mode.
+ * Setting the two MSBs of the LOW_LIMIT exponent to 11b makes the sensor
+ * assert INT at the end of every conversion; the interrupt is cleared by
+ * reading CONFIG. Disabling restores a low limit of zero.
+ */
+bool OPT3002::set_end_of_conversion_mode(bool enabled) {
+    return write(enabled ? opt3002_result_encode(12, 0) : 0, OPT3002_REGISTER::LOW_LIMIT);
+}
+
+#if !defined(OPT3002_NO_FLOAT)
 float OPT3002::convert_measurement(opt3002_result_t input) {
     // Calculate optical power [ref: Equation 1, OPT3002 Datasheet]
     // Optical_Power = R[11:0] * 2^(E[3:0]) * 1.2 nW/cm^2
-    uint32_t exponent = 1 << input.exponent;
-    uint32_t output = input.reading * exponent * 1.2;
-    return output;
+    // R * 2^E is below 2^24 for valid exponents, so it converts to float exactly
+    uint32_t scaled = uint32_t(opt3002_result_mantissa(input.raw)) << opt3002_result_exponent(input.raw);
+    return scaled * 1.2f;
 }
 
+/**
+ * Encode an optical power in nW/cm^2 given as a float.
+ * Negative inputs encode as zero; large inputs clamp at full scale.
+ *
+ * Scaling in float would round before the nearest mantissa is chosen (and
+ * double is no wider on AVR), so the float is split into its 24-bit
+ * significand S and exponent, input = S * 2^-shift, and the half-counts
+ * floor(input / 0.6) = floor((S * 5 >> shift) / 3) are formed exactly.
+ */
 opt3002_result_t OPT3002::convert_measurement(float input) {
-    uint8_t exponent = 0;
-    uint16 fractional = input / 1.2;
-    while (fractional >= (1 << 12) and exponent < (1 << 4)) {
-        fractional /= 2;
+    const float max_nw = 16777215.0f;
+    if (not(input > 0)) input = 0;
+    if (input > max_nw) input = max_nw;
+
+    uint32_t bits;
+    memcpy(&bits, &input, sizeof(bits));
+    uint8_t biased_exponent = bits >> 23;
+    uint32_t significand = bits & 0x007FFFFF;
+    if (biased_exponent == 0) {
+        biased_exponent = 1;  // Subnormal: no implicit bit
+    } else {
+        significand |= 0x00800000;
+    }
+
+    // The clamp keeps input below 2^24, so the shift is never negative
+    uint8_t shift = 150 - biased_exponent;
+    uint32_t scaled = shift < 32 ? (significand * 5) >> shift : 0;
+    return encode_half_counts(scaled / 3);
+}
+#endif
+
+// Number of significant bits in a value (0 for 0)
+static uint8_t bit_length(uint32_t value) {
+    if (value == 0) return 0;
+    return sizeof(unsigned long) * 8 - __builtin_clzl(value);
+}
+
+/**
+ * Shared core of the encoders.
+ * Working in half-counts (0.6 nW/cm^2 units, floored) lets rounding to the
+ * nearest mantissa be done with shifts: round(x / 2^E) where x = 2 * counts
+ * is ((floor(2x) >> E) + 1) >> 1. The exponent comes straight from the bit
+ * length, so the cost is the same for every input.
+ */
+opt3002_result_t OPT3002::encode_half_counts(uint32_t half_counts) {
+    const uint8_t top_exponent = 11;
+    const uint8_t mantissa_bits = 12;
+
+    int8_t exponent = int8_t(bit_length(half_counts)) - (mantissa_bits + 1);
+    if (exponent < 0) exponent = 0;
+
+    uint16_t reading = ((half_counts >> exponent) + 1) >> 1;
+    if (reading >> mantissa_bits) {
+        // Rounded up into the next exponent
+        reading >>= 1;
         exponent++;
     }
-    opt3002_result_t output;
-    output.exponent = exponent;
-    output.reading = fractional;
 
+    opt3002_result_t output;
+    output.raw = exponent > top_exponent ? opt3002_result_encode(top_exponent, 0x0FFF) : opt3002_result_encode(exponent, reading);
     return output;
 }
+
+// Inputs at or above this many half-counts are beyond full scale
+static const uint32_t MAX_HALF_COUNTS = uint32_t(1) << 26;
+
+opt3002_result_t OPT3002::encode_nw(uint32_t nanowatts) {
+    // 2 / 1.2 = 5 / 3; clamp first so the product cannot overflow
+    const uint32_t max_nw = MAX_HALF_COUNTS / 5 * 3;
+    if (nanowatts > max_nw) nanowatts = max_nw;
+    return encode_half_counts(nanowatts * 5 / 3);
+}
+
+opt3002_result_t OPT3002::encode_nw_x10(uint32_t tenths) { return encode_half_counts(tenths / 6); }
+
+opt3002_result_t OPT3002::encode_pw(uint64_t picowatts) {
+    uint64_t half_counts = picowatts / 600;
+    if (half_counts > MAX_HALF_COUNTS) half_counts = MAX_HALF_COUNTS;
+    return encode_half_counts(uint32_t(half_counts));
+}
@@ -1,8 +1,13 @@
-#include <Arduino.h>
-#include <Wire.h>
+#pragma once
+
+#include "OPT3002_codec.h"
+#include "OPT3002_transport.h"
 
 const uint8_t OPT3002_DEFAULT_ADDRESS = 0x44;
 const uint16_t OPT3002_MANUFACTURER_ID = 0x5449;
+const uint16_t OPT3002_CONFIG_RESET = 0xC810;      // Power-on CONFIG: auto-range, 800ms, shutdown, latched
+const uint16_t OPT3002_CONFIG_READ_ONLY =  // Flag bits of CONFIG: OVF, CRF, FH, FL
+    OPT3002_CONFIG_OVERFLOW | OPT3002_CONFIG_CONVERSION_READY | OPT3002_CONFIG_FLAG_HIGH | OPT3002_CONFIG_FLAG_LOW;
 
 /**
  * Operation modes of the sensor
@@ -88,7 +93,7 @@ typedef enum OPT3002_FAULT_CONFIG { OPT3002_FAULT_1 = 0, OPT3002_FAULT_2 = 1, OP
 typedef union {
     struct {
         uint8_t interrupt_fault_limit : 2;       // Number of measurements outside set levels required to trigger interrupt
-        bool mask_exponent_field_enabled : 1;    // Not sure...
+        bool mask_exponent_field_enabled : 1;    // Force the result exponent to 0 in manual range modes
         bool interrupt_active_high_enabled : 1;  // Polarity of interrupt signal [active high, active low]
         bool interrupt_latch_enabled : 1;        // Interrupt latch mode [transient, latched]
         bool low_limit_triggered : 1;            // Read-only. 1: Conversion lower than user's low limit
@@ -119,16 +124,59 @@ typedef union {
     uint16_t raw;
 } opt3002_result_t;
 
+/**
+ * High-resolution optical power.
+ * 1.2 nW/cm^2 is exactly 1200 pW/cm^2, so every valid result converts to
+ * picowatts without loss.
+ *
+ * Exponents 12-15 are outside the sensor's ranges; such words, and the
+ * full-scale word of the top range, are reported as saturated with the
+ * power clamped to the top of the 10M range.
+ */
+typedef struct {
+    uint64_t picowatts;  // Optical power in pW/cm^2
+    bool saturated;      // Reading at or beyond the sensor's full scale
+} opt3002_power_t;
+
+/**
+ * A raw measurement tagged with when and where it was taken.
+ */
+typedef struct {
+    uint32_t timestamp_us;    // Clock time at which the sample was taken
+    opt3002_result_t result;  // Raw result word
+    uint8_t address;          // I2C address of the sensor it came from
+} opt3002_sample_t;
+
+/**
+ * Receiver for samples produced by the acquisition helpers.
+ */
+typedef void (*opt3002_sample_callback_t)(const opt3002_sample_t &sample, void *context);
+
 /**
  * The driver for the OPT3002 illuminance sensor.
+ *
+ * Define OPT3002_NO_FLOAT in the build flags to remove every floating point
+ * overload; get_optical_power() and the convert_to_* helpers never use float.
  */
 class OPT3002 {
    public:
+#if defined(ARDUINO)
+    // Drive the sensor through the global Wire object
+    OPT3002();
+#endif
+
+    // Drive the sensor through any bus backend
+    OPT3002(OPT3002Transport &transport);
+
     // Start the sensor if comms work
     bool begin(uint8_t address = OPT3002_DEFAULT_ADDRESS);
 
     // Set the device i2c address of the sensor
     void set_address(uint8_t address);
+    uint8_t get_address() const { return _device_address; }
+
+    // Drop the cached register pointer, e.g. after other code has addressed the sensor
+    void forget_register_pointer() { _register_pointer = NO_POINTER; }
 
     // Check that the controller is able to communicate with the sensor over i2c
     bool check_comms();
@@ -140,26 +188,79 @@ class OPT3002 {
     // Read the sensor's current configuration
     opt3002_config_t get_config();
 
+    // Stage changes to the shadow CONFIG; nothing is sent until commit()
+    void set_mode(opt3002_mode_t mode);
+    void set_range(opt3002_range_t range);
+    void set_conversion_time(opt3002_conv_time_t conversion_time);
+    void set_interrupt_mode(opt3002_interrupt_mode_t interrupt_mode);
+    void set_interrupt_polarity(opt3002_interrupt_polarity_t polarity);
+    void set_fault_count(opt3002_fault_count_t fault_count);
+    void set_mask_exponent(bool enabled);
+
+    // Write the shadow CONFIG if any staged field changed
+    bool commit();
+
+    // Start a single-shot conversion with the shadow settings (always writes)
+    bool trigger();
+
+    // True if staged changes have not been written yet
+    bool is_config_dirty() const { return _config_dirty; }
+
+    // Driver-side copy of CONFIG, with flags as of the last CONFIG read
+    opt3002_config_t get_shadow_config() const { return _config; }
+
+    // Read CONFIG to update only the read-only flags in the shadow copy
+    opt3002_config_t refresh_flags();
+    bool refresh_flags(opt3002_config_t &config);
+
     // Get the optical power of the sensor's latest measurement
     uint32_t get_optical_power();
+    bool get_optical_power(opt3002_power_t &power);
+
+    // Read the raw result register
+    bool get_result(opt3002_result_t &result);
 
-    // Set the high limit for sensor measurements before faults occur
-    void set_high_limit(opt3002_result_t high_limit);
-    void set_high_limit(float high_limit);
+    // Set the high limit for sensor measurements before faults occur. Returns false if the write fails.
+    bool set_high_limit(opt3002_result_t high_limit);
+#if !defined(OPT3002_NO_FLOAT)
+    bool set_high_limit(float high_limit);
+#endif
 
     // Get the sensor's current high limit level
     opt3002_result_t get_high_limit();
 
-    // Set the low limit for sensor measurements before faults occur
-    void set_low_limit(opt3002_result_t low_limit);
-    void set_low_limit(float low_limit);
+    // Set the low limit for sensor measurements before faults occur. Returns false if the write fails.
+    bool set_low_limit(opt3002_result_t low_limit);
+#if !defined(OPT3002_NO_FLOAT)
+    bool set_low_limit(float low_limit);
+#endif
 
     // Get the sensor's current low limit level
     opt3002_result_t get_low_limit();
 
+    // Make the INT pin signal every completed conversion (uses LOW_LIMIT)
+    bool set_end_of_conversion_mode(bool enabled);
+
     // Convert between
+#if !defined(OPT3002_NO_FLOAT)
     opt3002_result_t convert_measurement(float input);
     float convert_measurement(opt3002_result_t input);
+#endif
+
+    // Float-free conversion of a result to whole nW/cm^2 (truncated)
+    static uint32_t convert_to_nw(opt3002_result_t input);
+
+    // Float-free conversion of a result to exact 0.1 nW/cm^2 units
+    static uint32_t convert_to_nw_x10(opt3002_result_t input);
+
+    // Float-free conversion of a result to exact pW/cm^2, flagging saturation
+    static opt3002_power_t convert_to_pw(opt3002_result_t input);
+
+    // Encode optical power into the result/limit format in constant time.
+    // Rounds to the nearest representable value and clamps at full scale.
+    static opt3002_result_t encode_nw(uint32_t nanowatts);
+    static opt3002_result_t encode_nw_x10(uint32_t tenths);
+    static opt3002_result_t encode_pw(uint64_t picowatts);
 
    private:
     /**
@@ -167,12 +268,31 @@ class OPT3002 {
      */
     typedef enum OPT3002_REGISTER { RESULT = 0x00, CONFIG = 0x01, LOW_LIMIT = 0x02, HIGH_LIMIT = 0x03, MANUFACTURER_ID = 0x7E } opt3002_reg_t;
 
+    // Bus the sensor is attached to
+    OPT3002Transport *_transport;
+
     // I2C address of the sensor
     uint8_t _device_address;
 
+    // Register the sensor's pointer is known to hold, or NO_POINTER if unknown.
+    // The sensor keeps its pointer between reads, so repeat reads of the same
+    // register can skip the pointer write.
+    static const uint8_t NO_POINTER = 0xFF;
+    uint8_t _register_pointer;
+
+    // Shadow copy of the CONFIG register
+    opt3002_config_t _config;
+    bool _config_dirty;
+
+    // Replace the writable fields of the shadow copy, marking it dirty on change
+    void stage_config(uint16_t raw);
+
     // Read from the sensor's registers
-    bool read(uint8_t *output, opt3002_reg_t address);
+    bool read(uint16_t &value, opt3002_reg_t address);
 
     // Write to the sensor's registers
-    bool write(uint8_t *input, opt3002_reg_t address);
+    bool write(uint16_t value, opt3002_reg_t address);
+
+    // Encode a value given in half-counts (units of 0.6 nW/cm^2)
+    static opt3002_result_t encode_half_counts(uint32_t half_counts);
 };
\ No newline at end of file
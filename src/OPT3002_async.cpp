@@ -0,0 +1,175 @@
+#include "OPT3002_async.h"
+
+OPT3002Acquisition::OPT3002Acquisition(OPT3002 &sensor, OPT3002Clock &clock)
+    : _sensor(&sensor),
+      _clock(&clock),
+      _callback(NULL),
+      _callback_context(NULL),
+      _busy(false),
+      _repeat(false),
+      _triggered(false),
+      _ready(false),
+      _started_us(0),
+      _check_us(0),
+      _conversion_us(0),
+      _available(false),
+      _status_reads(0),
+      _samples(0),
+      _bus_errors(0) {}
+
+void OPT3002Acquisition::set_callback(opt3002_sample_callback_t callback, void *context) {
+    _callback = callback;
+    _callback_context = context;
+}
+
+/**
+ * Trigger a single-shot conversion and schedule the first status check for
+ * when the conversion should be complete.
+ */
+bool OPT3002Acquisition::start(bool repeat) {
+    _repeat = repeat;
+    _conversion_us = opt3002_config_conversion_time(_sensor->get_shadow_config().raw) ? 800000UL : 100000UL;
+    _busy = trigger();
+    return _busy;
+}
+
+void OPT3002Acquisition::stop() {
+    _busy = false;
+    _repeat = false;
+}
+
+/**
+ * Start a conversion. If the trigger fails, the next check is soon, for
+ * poll() to send it again.
+ */
+bool OPT3002Acquisition::trigger() {
+    _ready = false;
+    _started_us = _clock->now_us();
+    _triggered = _sensor->trigger();
+    _check_us = _started_us + (_triggered ? _conversion_us : _conversion_us / 32);
+    return _triggered;
+}
+
+bool OPT3002Acquisition::poll() {
+    if (not _busy) return false;
+
+    uint32_t now = _clock->now_us();
+    if (not opt3002_time_reached(now, _check_us)) return false;
+
+    // Only while repeating: the trigger for the next conversion failed
+    if (not _triggered) {
+        if (not trigger()) _bus_errors++;
+        return false;
+    }
+
+    if (not _ready) {
+        _status_reads++;
+        opt3002_config_t flags;
+        if (not _sensor->refresh_flags(flags)) _bus_errors++;
+        if (not opt3002_config_flag(flags.raw, OPT3002_CONFIG_CONVERSION_READY)) {
+            // Running late: check again after a small fraction of the conversion
+            _check_us = now + _conversion_us / 32;
+            return false;
+        }
+        // The read cleared the flag; RESULT holds the sample until the next trigger
+        _ready = true;
+    }
+
+    opt3002_sample_t sample;
+    if (not _sensor->get_result(sample.result)) {
+        _bus_errors++;
+        if (_repeat) {
+            _check_us = now + _conversion_us / 32;
+        } else {
+            _busy = false;
+        }
+        return false;
+    }
+    sample.timestamp_us = _started_us;
+    sample.address = _sensor->get_address();
+
+    _sample = sample;
+    _available = true;
+    _samples++;
+
+    _busy = _repeat;
+    if (_repeat and not trigger()) _bus_errors++;
+    if (_callback) _callback(sample, _callback_context);
+    return true;
+}
+
+uint32_t OPT3002Acquisition::time_until_check() {
+    if (not _busy) return 0xFFFFFFFF;
+    uint32_t now = _clock->now_us();
+    return opt3002_time_reached(now, _check_us) ? 0 : _check_us - now;
+}
+
+opt3002_sample_t OPT3002Acquisition::take() {
+    _available = false;
+    return _sample;
+}
+
+OPT3002InterruptReader::OPT3002InterruptReader(OPT3002 &sensor, OPT3002Clock &clock)
+    : _sensor(&sensor), _clock(&clock), _callback(NULL), _callback_context(NULL), _pending(false), _available(false), _samples(0) {}
+
+void OPT3002InterruptReader::set_callback(opt3002_sample_callback_t callback, void *context) {
+    _callback = callback;
+    _callback_context = context;
+}
+
+/**
+ * Put the sensor into end-of-conversion mode.
+ * Latched interrupts keep INT asserted until service() reads CONFIG, so an
+ * edge cannot be missed while the main loop is busy.
+ */
+bool OPT3002InterruptReader::begin(opt3002_conv_time_t conversion_time, opt3002_interrupt_polarity_t polarity) {
+    _pending = false;
+    if (not _sensor->set_end_of_conversion_mode(true)) return false;
+
+    _sensor->set_interrupt_mode(OPT_INT_LATCHED);
+    _sensor->set_interrupt_polarity(polarity);
+    _sensor->set_conversion_time(conversion_time);
+    _sensor->set_mode(OPT3002_MODE_CONTINUOUS);
+    return _sensor->commit();
+}
+
+void OPT3002InterruptReader::end() {
+    _sensor->set_mode(OPT3002_MODE_SHUTDOWN);
+    _sensor->commit();
+    _sensor->set_end_of_conversion_mode(false);
+    _pending = false;
+}
+
+bool OPT3002InterruptReader::service() {
+    if (not _pending) return false;
+    _pending = false;
+
+    // Acknowledge the interrupt before reading RESULT. A conversion that
+    // completes in between asserts INT again rather than being acknowledged
+    // unread. If either read fails, stay pending for the next call to retry:
+    // an unacknowledged INT stays asserted and raises no new edge.
+    opt3002_config_t flags;
+    if (not _sensor->refresh_flags(flags)) {
+        _pending = true;
+        return false;
+    }
+
+    opt3002_sample_t sample;
+    sample.timestamp_us = _clock->now_us();
+    if (not _sensor->get_result(sample.result)) {
+        _pending = true;
+        return false;
+    }
+
+    sample.address = _sensor->get_address();
+    _sample = sample;
+    _available = true;
+    _samples++;
+    if (_callback) _callback(sample, _callback_context);
+    return true;
+}
+
+opt3002_sample_t OPT3002InterruptReader::take() {
+    _available = false;
+    return _sample;
+}
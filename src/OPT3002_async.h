@@ -0,0 +1,128 @@
+#pragma once
+
+#include "OPT3002.h"
+#include "OPT3002_clock.h"
+
+/**
+ * Non-blocking single-shot acquisition.
+ *
+ * start() triggers a conversion and returns immediately. poll() is cheap to
+ * call from a main loop: it does nothing until the conversion time has
+ * elapsed, then checks the conversion-ready flag once, and only backs off in
+ * small steps if the sensor runs late. Completed samples go to the callback
+ * (if set) and to a one-slot mailbox read with available()/take().
+ *
+ * In repeat mode a failed bus transfer is counted and retried on a later
+ * poll(): a RESULT read that fails is read again, and a trigger that fails
+ * is sent again. A single conversion whose RESULT cannot be read is
+ * abandoned.
+ */
+class OPT3002Acquisition {
+   public:
+    OPT3002Acquisition(OPT3002 &sensor, OPT3002Clock &clock);
+
+    // Deliver each completed sample to a callback
+    void set_callback(opt3002_sample_callback_t callback, void *context = NULL);
+
+    // Trigger a conversion. With repeat set, a new one starts after each sample.
+    bool start(bool repeat = false);
+
+    // Abandon the current conversion and stop repeating
+    void stop();
+
+    // Advance the state machine without blocking. Returns true if a sample completed.
+    bool poll();
+
+    bool is_busy() const { return _busy; }
+
+    // Microseconds until poll() next touches the bus
+    uint32_t time_until_check();
+
+    // Latest completed sample
+    bool available() const { return _available; }
+    opt3002_sample_t take();
+
+    // Number of CONFIG reads made while waiting, and samples completed
+    uint32_t get_status_reads() const { return _status_reads; }
+    uint32_t get_samples() const { return _samples; }
+
+    // Number of triggers, CONFIG reads and RESULT reads that failed after start()
+    uint32_t get_bus_errors() const { return _bus_errors; }
+
+   private:
+    OPT3002 *_sensor;
+    OPT3002Clock *_clock;
+
+    opt3002_sample_callback_t _callback;
+    void *_callback_context;
+
+    bool _busy;
+    bool _repeat;
+    bool _triggered;  // The conversion in progress was started
+    bool _ready;      // The conversion is complete but RESULT is not read yet
+    uint32_t _started_us;
+    uint32_t _check_us;
+    uint32_t _conversion_us;
+
+    opt3002_sample_t _sample;
+    bool _available;
+
+    uint32_t _status_reads;
+    uint32_t _samples;
+    uint32_t _bus_errors;
+
+    bool trigger();
+};
+
+/**
+ * Interrupt-driven acquisition using end-of-conversion mode.
+ *
+ * begin() puts the sensor into continuous conversions with INT asserted at
+ * the end of each one. The pin's interrupt handler calls notify(), which
+ * only sets a flag; service() from the main loop then reads CONFIG to clear
+ * the interrupt and reads RESULT. The bus is never touched between
+ * interrupts.
+ */
+class OPT3002InterruptReader {
+   public:
+    OPT3002InterruptReader(OPT3002 &sensor, OPT3002Clock &clock);
+
+    // Deliver each completed sample to a callback
+    void set_callback(opt3002_sample_callback_t callback, void *context = NULL);
+
+    // Configure end-of-conversion interrupts and start continuous conversions
+    bool begin(opt3002_conv_time_t conversion_time = OPT3002_CONV_TIME_100MS,
+               opt3002_interrupt_polarity_t polarity = OPT3002_ACTIVE_LOW);
+
+    // Leave end-of-conversion mode and shut the sensor down
+    void end();
+
+    // Call from the INT pin interrupt handler
+    void notify() { _pending = true; }
+
+    // True if notify() has been called since the last service()
+    bool is_pending() const { return _pending; }
+
+    // Read the new result if the interrupt flagged one. Returns true on a new
+    // sample; if the sensor could not be read it stays pending.
+    bool service();
+
+    // Latest completed sample
+    bool available() const { return _available; }
+    opt3002_sample_t take();
+
+    uint32_t get_samples() const { return _samples; }
+
+   private:
+    OPT3002 *_sensor;
+    OPT3002Clock *_clock;
+
+    opt3002_sample_callback_t _callback;
+    void *_callback_context;
+
+    volatile bool _pending;
+
+    opt3002_sample_t _sample;
+    bool _available;
+    uint32_t _samples;
+};
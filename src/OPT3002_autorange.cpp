@@ -0,0 +1,120 @@
+#include "OPT3002_autorange.h"
+
+static const uint8_t TOP_RANGE = OPT3002_RANGE_10M;
+
+OPT3002AutoRange::OPT3002AutoRange(OPT3002 &sensor)
+    : _sensor(&sensor),
+      _range(OPT3002_RANGE_40K),
+      _low_readings(0),
+      _peak_level(0),
+      _settling(false),
+      _range_changes(0),
+      _settling_conversions(0),
+      _failed_writes(0) {}
+
+bool OPT3002AutoRange::begin(opt3002_range_t initial_range) {
+    _range = initial_range;
+    _low_readings = 0;
+    _peak_level = 0;
+    _settling = false;
+
+    // The exponent field tells update() which range each reading came from
+    _sensor->set_mask_exponent(false);
+    _sensor->set_range(_range);
+    return _sensor->commit();
+}
+
+/**
+ * Pick the range for a level after one reading taken in range `current`.
+ * Moving down uses the mantissa to find, in one step, the number of halvings
+ * that brings it up to (at most) TARGET.
+ */
+opt3002_range_t OPT3002AutoRange::choose(opt3002_range_t current, uint16_t mantissa, bool overflow) {
+    int8_t range = current;
+
+    if (overflow) {
+        range += OVERFLOW_STEP;
+    } else if (mantissa >= UP_THRESHOLD) {
+        range += 1;
+    } else if (mantissa < DOWN_THRESHOLD) {
+        if (mantissa == 0) {
+            range = 0;
+        } else {
+            uint8_t steps = 0;
+            while ((uint32_t(mantissa) << (steps + 1)) <= TARGET) steps++;
+            range -= steps;
+        }
+    }
+
+    if (range < 0) range = 0;
+    if (range > TOP_RANGE) range = TOP_RANGE;
+    return (opt3002_range_t)range;
+}
+
+/**
+ * Write a range to the sensor. _range only follows once the write succeeds,
+ * so it always names the range the sensor is converting in; after a failure
+ * the change stays staged and update() retries it.
+ */
+bool OPT3002AutoRange::apply_range(opt3002_range_t range) {
+    _sensor->set_range(range);
+    if (not _sensor->commit()) {
+        _failed_writes++;
+        return false;
+    }
+    if (range != _range) {
+        _range = range;
+        _range_changes++;
+        _settling = true;
+    }
+    return true;
+}
+
+/**
+ * Feed one conversion.
+ * Readings are judged in the range they were taken in (their exponent), as a
+ * conversion already under way when the range changed still completes in the
+ * old range. Moving up happens at once; moving down waits for DOWN_HOLD low
+ * readings in a row and then sizes the move for the highest of them, so a
+ * flickering source does not bounce between ranges.
+ */
+bool OPT3002AutoRange::update(opt3002_result_t result, bool overflow) {
+    opt3002_range_t taken_in = (opt3002_range_t)opt3002_result_exponent(result.raw);
+    uint16_t mantissa = opt3002_result_mantissa(result.raw);
+    bool too_high = overflow or (mantissa >= UP_THRESHOLD and taken_in < TOP_RANGE);
+    bool too_low = not overflow and mantissa < DOWN_THRESHOLD and taken_in > 0;
+
+    opt3002_range_t next = _range;
+    if (too_high) {
+        _low_readings = 0;
+        _peak_level = 0;
+        next = choose(taken_in, mantissa, overflow);
+        if (next < _range) next = _range;
+    } else if (too_low) {
+        uint32_t level = uint32_t(mantissa) << taken_in;
+        if (level > _peak_level) _peak_level = level;
+        if (++_low_readings >= DOWN_HOLD) {
+            // Express the peak in the current range to size the move
+            uint32_t peak_mantissa = _peak_level >> _range;
+            next = choose(_range, peak_mantissa > 0x0FFF ? 0x0FFF : peak_mantissa, false);
+            if (next > _range) next = _range;
+            _low_readings = 0;
+            _peak_level = 0;
+        }
+    } else {
+        _low_readings = 0;
+        _peak_level = 0;
+    }
+
+    // A CONFIG write that failed earlier is retried with the latest choice
+    if (next != _range or _sensor->is_config_dirty()) apply_range(next);
+
+    if (_settling) {
+        if (too_high or too_low or taken_in != _range) {
+            _settling_conversions++;
+        } else {
+            _settling = false;
+        }
+    }
+    return not overflow;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "OPT3002.h"
+
+/**
+ * Driver-side auto-ranging for the manual range modes.
+ *
+ * After each conversion the engine looks at the mantissa and the overflow
+ * flag and moves the range so that the next reading lands in the upper part
+ * of the mantissa span:
+ *  - overflow: the true level is unknown, so jump up several ranges at once
+ *  - mantissa above UP_THRESHOLD: move up one range
+ *  - mantissa below DOWN_THRESHOLD for DOWN_HOLD conversions in a row: move
+ *    down as many ranges as it takes to bring the highest of those readings
+ *    back near TARGET in one step
+ * The gap between the thresholds (after the 2x change of a range step) is the
+ * hysteresis that keeps a steady level from toggling between ranges.
+ */
+class OPT3002AutoRange {
+   public:
+    static const uint16_t UP_THRESHOLD = 3686;    // ~90% of full scale
+    static const uint16_t DOWN_THRESHOLD = 1536;  // 37.5%; one step down lands at 75%
+    static const uint16_t TARGET = 3072;          // Aim for 75% when moving down
+    static const uint8_t OVERFLOW_STEP = 3;       // Ranges to climb on overflow (8x)
+    static const uint8_t DOWN_HOLD = 3;           // Low readings needed before moving down
+
+    OPT3002AutoRange(OPT3002 &sensor);
+
+    // Switch the sensor to a manual starting range
+    bool begin(opt3002_range_t initial_range = OPT3002_RANGE_40K);
+
+    // Feed a completed conversion. Moves the range if needed and returns
+    // true if the reading itself is usable (not an overflow).
+    bool update(opt3002_result_t result, bool overflow);
+
+    opt3002_range_t get_range() const { return _range; }
+
+    // Decide the next range from a reading taken in the current one
+    static opt3002_range_t choose(opt3002_range_t current, uint16_t mantissa, bool overflow);
+
+    // Range changes made, and conversions spent between a change and the
+    // first in-band reading taken in the new range
+    uint32_t get_range_changes() const { return _range_changes; }
+    uint32_t get_settling_conversions() const { return _settling_conversions; }
+
+    // Range changes the sensor did not accept; each is retried on the next update()
+    uint32_t get_failed_writes() const { return _failed_writes; }
+
+   private:
+    OPT3002 *_sensor;
+    opt3002_range_t _range;
+
+    // Run of low readings and the highest level (mantissa << exponent) in it
+    uint8_t _low_readings;
+    uint32_t _peak_level;
+
+    bool _settling;
+    uint32_t _range_changes;
+    uint32_t _settling_conversions;
+    uint32_t _failed_writes;
+
+    bool apply_range(opt3002_range_t range);
+};
@@ -0,0 +1,266 @@
+#include "OPT3002_bulk.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && defined(__GNUC__)
+#define OPT3002_DECODE_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * The vector kernels avoid per-lane shifts where the instruction set has
+ * none. 2^E is built directly as a float by placing E + 127 in the exponent
+ * field, and R * 2^E then comes out of a float multiply exactly: R has at
+ * most 12 significant bits, so scaling it by a power of two never rounds.
+ * The same holds for R * 12 (16 bits, the tenths of a nW) as long as the
+ * product stays below 2^31 for the conversion back, which it does for every
+ * exponent. This is also why float(R << E) in the scalar path equals
+ * float(R) * 2^E bit for bit, even for the exponents above 11.
+ */
+
+// Same expressions as the OPT3002 conversions
+#if !defined(OPT3002_NO_FLOAT)
+static void decode_float_scalar(const uint16_t *words, float *output, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t scaled = uint32_t(opt3002_result_mantissa(words[i])) << opt3002_result_exponent(words[i]);
+        output[i] = scaled * 1.2f;
+    }
+}
+#endif
+
+static void decode_nw_x10_scalar(const uint16_t *words, uint32_t *output, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        opt3002_result_t result;
+        result.raw = words[i];
+        output[i] = OPT3002::convert_to_nw_x10(result);
+    }
+}
+
+static size_t decode_pw_scalar(const uint16_t *words, uint64_t *output, size_t count) {
+    size_t saturated = 0;
+    for (size_t i = 0; i < count; i++) {
+        opt3002_result_t result;
+        result.raw = words[i];
+        opt3002_power_t power = OPT3002::convert_to_pw(result);
+        output[i] = power.picowatts;
+        saturated += power.saturated;
+    }
+    return saturated;
+}
+
+#if defined(OPT3002_DECODE_X86)
+// Load four words as 32-bit mantissas and exponents
+static inline void load_sse2(const uint16_t *words, __m128i &mantissa, __m128i &exponent) {
+    __m128i raw = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)words), _mm_setzero_si128());
+    mantissa = _mm_and_si128(raw, _mm_set1_epi32(0x0FFF));
+    exponent = _mm_srli_epi32(raw, 12);
+}
+
+static inline __m128 power_of_two_sse2(__m128i exponent) { return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(exponent, _mm_set1_epi32(127)), 23)); }
+
+#if !defined(OPT3002_NO_FLOAT)
+static void decode_float_sse2(const uint16_t *words, float *output, size_t count) {
+    const __m128 nw_per_count = _mm_set1_ps(1.2f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i mantissa, exponent;
+        load_sse2(words + i, mantissa, exponent);
+        __m128 scaled = _mm_mul_ps(_mm_cvtepi32_ps(mantissa), power_of_two_sse2(exponent));
+        _mm_storeu_ps(output + i, _mm_mul_ps(scaled, nw_per_count));
+    }
+    decode_float_scalar(words + i, output + i, count - i);
+}
+#endif
+
+static void decode_nw_x10_sse2(const uint16_t *words, uint32_t *output, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i mantissa, exponent;
+        load_sse2(words + i, mantissa, exponent);
+        __m128i tenths = _mm_add_epi32(_mm_slli_epi32(mantissa, 3), _mm_slli_epi32(mantissa, 2));
+        __m128 scaled = _mm_mul_ps(_mm_cvtepi32_ps(tenths), power_of_two_sse2(exponent));
+        _mm_storeu_si128((__m128i *)(output + i), _mm_cvttps_epi32(scaled));
+    }
+    decode_nw_x10_scalar(words + i, output + i, count - i);
+}
+
+/**
+ * Saturated words are clamped to the top of the 10M range, R * 1200 is formed
+ * with shifts, and the 64-bit products with 2^E come from the unsigned
+ * 32x32 multiply, which covers the even lanes and then the odd ones.
+ */
+static size_t decode_pw_sse2(const uint16_t *words, uint64_t *output, size_t count) {
+    const __m128i top_exponent = _mm_set1_epi32(11);
+    const __m128i full_scale = _mm_set1_epi32(0x0FFF);
+    size_t saturated = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i mantissa, exponent;
+        load_sse2(words + i, mantissa, exponent);
+
+        __m128i beyond = _mm_cmpgt_epi32(exponent, top_exponent);
+        mantissa = _mm_or_si128(mantissa, _mm_and_si128(beyond, full_scale));
+        exponent = _mm_or_si128(_mm_andnot_si128(beyond, exponent), _mm_and_si128(beyond, top_exponent));
+        __m128i at_top = _mm_and_si128(_mm_cmpeq_epi32(exponent, top_exponent), _mm_cmpeq_epi32(mantissa, full_scale));
+        saturated += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(at_top)));
+
+        // 1200 = 1024 + 128 + 32 + 16
+        __m128i scaled = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(mantissa, 10), _mm_slli_epi32(mantissa, 7)),
+                                       _mm_add_epi32(_mm_slli_epi32(mantissa, 5), _mm_slli_epi32(mantissa, 4)));
+        __m128i multiplier = _mm_cvttps_epi32(power_of_two_sse2(exponent));
+        __m128i even = _mm_mul_epu32(scaled, multiplier);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(scaled, 32), _mm_srli_epi64(multiplier, 32));
+        _mm_storeu_si128((__m128i *)(output + i), _mm_unpacklo_epi64(even, odd));
+        _mm_storeu_si128((__m128i *)(output + i + 2), _mm_unpackhi_epi64(even, odd));
+    }
+    return saturated + decode_pw_scalar(words + i, output + i, count - i);
+}
+
+// AVX2 has per-lane shifts, so these follow the scalar code directly
+#define OPT3002_AVX2 __attribute__((target("avx2")))
+
+OPT3002_AVX2 static inline void load_avx2(const uint16_t *words, __m256i &mantissa, __m256i &exponent) {
+    __m256i raw = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)words));
+    mantissa = _mm256_and_si256(raw, _mm256_set1_epi32(0x0FFF));
+    exponent = _mm256_srli_epi32(raw, 12);
+}
+
+#if !defined(OPT3002_NO_FLOAT)
+OPT3002_AVX2 static void decode_float_avx2(const uint16_t *words, float *output, size_t count) {
+    const __m256 nw_per_count = _mm256_set1_ps(1.2f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i mantissa, exponent;
+        load_avx2(words + i, mantissa, exponent);
+        __m256 scaled = _mm256_cvtepi32_ps(_mm256_sllv_epi32(mantissa, exponent));
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(scaled, nw_per_count));
+    }
+    decode_float_scalar(words + i, output + i, count - i);
+}
+#endif
+
+OPT3002_AVX2 static void decode_nw_x10_avx2(const uint16_t *words, uint32_t *output, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i mantissa, exponent;
+        load_avx2(words + i, mantissa, exponent);
+        __m256i tenths = _mm256_add_epi32(_mm256_slli_epi32(mantissa, 3), _mm256_slli_epi32(mantissa, 2));
+        _mm256_storeu_si256((__m256i *)(output + i), _mm256_sllv_epi32(tenths, exponent));
+    }
+    decode_nw_x10_scalar(words + i, output + i, count - i);
+}
+
+OPT3002_AVX2 static size_t decode_pw_avx2(const uint16_t *words, uint64_t *output, size_t count) {
+    const __m256i top_exponent = _mm256_set1_epi32(11);
+    const __m256i full_scale = _mm256_set1_epi32(0x0FFF);
+    size_t saturated = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i mantissa, exponent;
+        load_avx2(words + i, mantissa, exponent);
+
+        __m256i beyond = _mm256_cmpgt_epi32(exponent, top_exponent);
+        mantissa = _mm256_or_si256(mantissa, _mm256_and_si256(beyond, full_scale));
+        exponent = _mm256_min_epu32(exponent, top_exponent);
+        __m256i at_top = _mm256_and_si256(_mm256_cmpeq_epi32(exponent, top_exponent), _mm256_cmpeq_epi32(mantissa, full_scale));
+        saturated += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(at_top)));
+
+        __m256i scaled = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(mantissa, 10), _mm256_slli_epi32(mantissa, 7)),
+                                          _mm256_add_epi32(_mm256_slli_epi32(mantissa, 5), _mm256_slli_epi32(mantissa, 4)));
+        __m256i low = _mm256_sllv_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(scaled)),
+                                        _mm256_cvtepu32_epi64(_mm256_castsi256_si128(exponent)));
+        __m256i high = _mm256_sllv_epi64(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(scaled, 1)),
+                                         _mm256_cvtepu32_epi64(_mm256_extracti128_si256(exponent, 1)));
+        _mm256_storeu_si256((__m256i *)(output + i), low);
+        _mm256_storeu_si256((__m256i *)(output + i + 4), high);
+    }
+    return saturated + decode_pw_scalar(words + i, output + i, count - i);
+}
+#endif
+
+static bool kernel_available(opt3002_decode_kernel_t kernel) {
+    switch (kernel) {
+        case OPT3002_DECODE_SCALAR:
+            return true;
+#if defined(OPT3002_DECODE_X86)
+        case OPT3002_DECODE_SSE2:
+            return true;
+        case OPT3002_DECODE_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+static opt3002_decode_kernel_t fastest_kernel() {
+    if (kernel_available(OPT3002_DECODE_AVX2)) return OPT3002_DECODE_AVX2;
+    if (kernel_available(OPT3002_DECODE_SSE2)) return OPT3002_DECODE_SSE2;
+    return OPT3002_DECODE_SCALAR;
+}
+
+// Picked once, on first use. C++11 makes the initialisation of a local
+// static thread-safe, so conversions may start on several threads at once.
+static opt3002_decode_kernel_t &chosen_kernel() {
+    static opt3002_decode_kernel_t kernel = fastest_kernel();
+    return kernel;
+}
+
+opt3002_decode_kernel_t opt3002_decode_get_kernel() { return chosen_kernel(); }
+
+bool opt3002_decode_set_kernel(opt3002_decode_kernel_t kernel) {
+    if (not kernel_available(kernel)) return false;
+    chosen_kernel() = kernel;
+    return true;
+}
+
+const char *opt3002_decode_kernel_name(opt3002_decode_kernel_t kernel) {
+    switch (kernel) {
+        case OPT3002_DECODE_SSE2:
+            return "sse2";
+        case OPT3002_DECODE_AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+#if !defined(OPT3002_NO_FLOAT)
+void opt3002_decode_float(const uint16_t *words, float *output, size_t count) {
+    switch (opt3002_decode_get_kernel()) {
+#if defined(OPT3002_DECODE_X86)
+        case OPT3002_DECODE_AVX2:
+            return decode_float_avx2(words, output, count);
+        case OPT3002_DECODE_SSE2:
+            return decode_float_sse2(words, output, count);
+#endif
+        default:
+            return decode_float_scalar(words, output, count);
+    }
+}
+#endif
+
+void opt3002_decode_nw_x10(const uint16_t *words, uint32_t *output, size_t count) {
+    switch (opt3002_decode_get_kernel()) {
+#if defined(OPT3002_DECODE_X86)
+        case OPT3002_DECODE_AVX2:
+            return decode_nw_x10_avx2(words, output, count);
+        case OPT3002_DECODE_SSE2:
+            return decode_nw_x10_sse2(words, output, count);
+#endif
+        default:
+            return decode_nw_x10_scalar(words, output, count);
+    }
+}
+
+size_t opt3002_decode_pw(const uint16_t *words, uint64_t *output, size_t count) {
+    switch (opt3002_decode_get_kernel()) {
+#if defined(OPT3002_DECODE_X86)
+        case OPT3002_DECODE_AVX2:
+            return decode_pw_avx2(words, output, count);
+        case OPT3002_DECODE_SSE2:
+            return decode_pw_sse2(words, output, count);
+#endif
+        default:
+            return decode_pw_scalar(words, output, count);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "OPT3002.h"
+
+/**
+ * Bulk conversion of raw result words.
+ *
+ * Each function converts count words from the RESULT (or limit) register
+ * format, as held in opt3002_result_t::raw, and gives exactly the value the
+ * matching single-word conversion in OPT3002 gives for every one of the
+ * 65536 possible words:
+ *
+ *   opt3002_decode_float()   OPT3002::convert_measurement(), nW/cm^2
+ *   opt3002_decode_nw_x10()  OPT3002::convert_to_nw_x10(), 0.1 nW/cm^2
+ *   opt3002_decode_pw()      OPT3002::convert_to_pw(), pW/cm^2
+ *
+ * On x86 the work is done eight or four words at a time with AVX2 or SSE2,
+ * picked when the first call is made; elsewhere, and for the tail of each
+ * span, a plain loop is used. Input and output need no particular alignment.
+ */
+
+/**
+ * Implementation behind the bulk conversions.
+ */
+typedef enum OPT3002_DECODE_KERNEL {
+    OPT3002_DECODE_SCALAR = 0,  // One word at a time, on any target
+    OPT3002_DECODE_SSE2 = 1,    // Four words per step
+    OPT3002_DECODE_AVX2 = 2,    // Eight words per step
+} opt3002_decode_kernel_t;
+
+#if !defined(OPT3002_NO_FLOAT)
+void opt3002_decode_float(const uint16_t *words, float *output, size_t count);
+#endif
+
+void opt3002_decode_nw_x10(const uint16_t *words, uint32_t *output, size_t count);
+
+// Returns the number of saturated words (see opt3002_power_t)
+size_t opt3002_decode_pw(const uint16_t *words, uint64_t *output, size_t count);
+
+// The kernel in use: the fastest one the processor supports, unless overridden
+opt3002_decode_kernel_t opt3002_decode_get_kernel();
+
+// Override the kernel, e.g. to compare them. Returns false if it is not
+// available on this build or processor. Not to be called while any thread
+// is converting.
+bool opt3002_decode_set_kernel(opt3002_decode_kernel_t kernel);
+
+// Name of a kernel for reports
+const char *opt3002_decode_kernel_name(opt3002_decode_kernel_t kernel);
@@ -0,0 +1,172 @@
+#include "OPT3002_bus.h"
+
+OPT3002Bus::OPT3002Bus(OPT3002Transport &transport, OPT3002Clock &clock)
+    : _clock(&clock),
+      _devices{OPT3002(transport), OPT3002(transport), OPT3002(transport), OPT3002(transport)},
+      _device_count(0),
+      _period_us(0),
+      _start_us(0),
+      _samples(0),
+      _trigger_skew_us(0) {}
+
+/**
+ * Probe every ADDR pin option.
+ * @return: Number of sensors found.
+ */
+uint8_t OPT3002Bus::begin() {
+    _device_count = 0;
+    for (uint8_t address = OPT3002_DEFAULT_ADDRESS; address < OPT3002_DEFAULT_ADDRESS + MAX_DEVICES; address++) {
+        add(address);
+    }
+    return _device_count;
+}
+
+bool OPT3002Bus::add(uint8_t address) {
+    if (_device_count >= MAX_DEVICES) return false;
+
+    OPT3002 &device = _devices[_device_count];
+    if (not device.begin(address)) return false;
+
+    _device_count++;
+    return true;
+}
+
+/**
+ * Start every sensor converting.
+ * The CONFIG writes go out back to back so that the conversion windows of
+ * all sensors are offset only by one transaction each.
+ */
+bool OPT3002Bus::start(opt3002_conv_time_t conversion_time, opt3002_range_t range) {
+    _period_us = conversion_time == OPT3002_CONV_TIME_800MS ? 800000UL : 100000UL;
+
+    bool success = true;
+    for (uint8_t i = 0; i < _device_count; i++) {
+        OPT3002 &device = _devices[i];
+        device.set_conversion_time(conversion_time);
+        device.set_range(range);
+        device.set_mode(OPT3002_MODE_CONTINUOUS);
+        success &= device.commit();
+        _due_us[i] = _clock->now_us() + _period_us;
+    }
+
+    _start_us = _clock->now_us();
+    _samples = 0;
+    return success;
+}
+
+void OPT3002Bus::stop() {
+    for (uint8_t i = 0; i < _device_count; i++) {
+        _devices[i].set_mode(OPT3002_MODE_SHUTDOWN);
+        _devices[i].commit();
+    }
+}
+
+/**
+ * Read every sensor whose conversion should have finished.
+ * Each due sensor's conversion-ready flag is checked before its result is
+ * read. A sensor that is ready on time keeps its schedule; one that runs
+ * late is re-checked shortly and then re-phased to when it became ready.
+ */
+uint8_t OPT3002Bus::service(opt3002_sample_callback_t callback, void *context) {
+    uint8_t delivered = 0;
+    for (uint8_t i = 0; i < _device_count; i++) {
+        uint32_t now = _clock->now_us();
+        if (not opt3002_time_reached(now, _due_us[i])) continue;
+
+        OPT3002 &device = _devices[i];
+        if (not opt3002_config_flag(device.refresh_flags().raw, OPT3002_CONFIG_CONVERSION_READY)) {
+            _due_us[i] = now + RETRY_US;
+            continue;
+        }
+
+        opt3002_sample_t sample;
+        if (not device.get_result(sample.result)) continue;
+        sample.timestamp_us = now;
+        sample.address = device.get_address();
+
+        bool on_time = now - _due_us[i] < RETRY_US;
+        _due_us[i] = (on_time ? _due_us[i] : now) + _period_us;
+
+        _samples++;
+        delivered++;
+        if (callback) callback(sample, context);
+    }
+    return delivered;
+}
+
+/**
+ * Take one synchronised reading from every sensor.
+ * All triggers are issued before any status is polled, so the conversion
+ * windows are offset only by the time of one CONFIG write per sensor.
+ */
+uint8_t OPT3002Bus::acquire_all(opt3002_sample_t *samples, uint32_t timeout_us) {
+    uint32_t started_us[MAX_DEVICES];
+    uint32_t shortest_us = 800000UL;
+    uint32_t longest_us = 0;
+    uint8_t pending = 0;
+    for (uint8_t i = 0; i < _device_count; i++) {
+        OPT3002 &device = _devices[i];
+        started_us[i] = _clock->now_us();
+        if (not device.trigger()) continue;
+        pending |= 1 << i;
+
+        uint32_t conversion_us = opt3002_config_conversion_time(device.get_shadow_config().raw) ? 800000UL : 100000UL;
+        if (conversion_us < shortest_us) shortest_us = conversion_us;
+        if (conversion_us > longest_us) longest_us = conversion_us;
+    }
+    if (not pending) return 0;
+
+    // Skew covers only the sensors that were triggered
+    uint32_t first_us = 0;
+    uint32_t last_us = 0;
+    bool found = false;
+    for (uint8_t i = 0; i < _device_count; i++) {
+        if (not(pending & (1 << i))) continue;
+        if (not found) first_us = started_us[i];
+        last_us = started_us[i];
+        found = true;
+    }
+    _trigger_skew_us = last_us - first_us;
+    if (timeout_us == 0) timeout_us = 2 * longest_us;
+
+    // Nothing can be ready before the shortest conversion ends
+    uint32_t waited_us = _clock->now_us() - first_us;
+    if (waited_us < shortest_us) _clock->sleep_us(shortest_us - waited_us);
+
+    uint8_t acquired = 0;
+    while (pending) {
+        for (uint8_t i = 0; i < _device_count; i++) {
+            if (not(pending & (1 << i))) continue;
+
+            OPT3002 &device = _devices[i];
+            if (not opt3002_config_flag(device.refresh_flags().raw, OPT3002_CONFIG_CONVERSION_READY)) continue;
+            pending &= ~(1 << i);
+
+            opt3002_sample_t &sample = samples[acquired];
+            if (not device.get_result(sample.result)) continue;
+            sample.timestamp_us = started_us[i];
+            sample.address = device.get_address();
+            acquired++;
+        }
+        if (not pending or _clock->now_us() - first_us >= timeout_us) break;
+        _clock->sleep_us(RETRY_US);
+    }
+    return acquired;
+}
+
+uint32_t OPT3002Bus::time_until_due() {
+    uint32_t now = _clock->now_us();
+    uint32_t shortest = _period_us;
+    for (uint8_t i = 0; i < _device_count; i++) {
+        if (opt3002_time_reached(now, _due_us[i])) return 0;
+        uint32_t remaining = _due_us[i] - now;
+        if (remaining < shortest) shortest = remaining;
+    }
+    return shortest;
+}
+
+uint32_t OPT3002Bus::get_sample_rate_mhz() {
+    uint32_t elapsed_us = _clock->now_us() - _start_us;
+    if (elapsed_us == 0) return 0;
+    return uint32_t(uint64_t(_samples) * 1000000000ULL / elapsed_us);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "OPT3002.h"
+#include "OPT3002_clock.h"
+
+/**
+ * Manager for up to four OPT3002s sharing one bus (ADDR pin options 0x44-0x47).
+ *
+ * All sensors run continuous conversions that are started back to back, so
+ * their integration windows overlap almost completely. service() then reads
+ * every sensor whose conversion is due in one burst, keeping four channels
+ * close to the limit set by the conversion time (40 samples/s at 100ms).
+ */
+class OPT3002Bus {
+   public:
+    static const uint8_t MAX_DEVICES = 4;
+
+    OPT3002Bus(OPT3002Transport &transport, OPT3002Clock &clock);
+
+    // Probe all four addresses and keep the sensors that answer
+    uint8_t begin();
+
+    // Add a sensor at a specific address. Returns false if it does not answer.
+    bool add(uint8_t address);
+
+    uint8_t get_device_count() const { return _device_count; }
+    OPT3002 &get_device(uint8_t index) { return _devices[index]; }
+
+    // Start continuous conversions on every sensor
+    bool start(opt3002_conv_time_t conversion_time = OPT3002_CONV_TIME_100MS, opt3002_range_t range = OPT3002_RANGE_AUTO);
+
+    // Put every sensor back into shutdown
+    void stop();
+
+    // Read all sensors with a conversion due. Returns the number of samples delivered.
+    uint8_t service(opt3002_sample_callback_t callback, void *context = NULL);
+
+    // Trigger a single-shot conversion on every sensor with minimal gaps,
+    // wait for all of them and read them back. Samples are timestamped with
+    // the start of their conversion. Blocks on the clock; a timeout of 0 waits
+    // for twice the longest conversion time. Returns the number of samples.
+    uint8_t acquire_all(opt3002_sample_t *samples, uint32_t timeout_us = 0);
+
+    // Spread of conversion start times in the last acquire_all()
+    uint32_t get_trigger_skew_us() const { return _trigger_skew_us; }
+
+    // Microseconds until the next conversion is due (0 if one is due now)
+    uint32_t time_until_due();
+
+    // Aggregate throughput since start()
+    uint32_t get_samples() const { return _samples; }
+    uint32_t get_sample_rate_mhz();  // millihertz, i.e. samples per 1000s
+
+   private:
+    // Delay before re-checking a sensor that was not ready when expected
+    static const uint32_t RETRY_US = 1000;
+
+    OPT3002Clock *_clock;
+    OPT3002 _devices[MAX_DEVICES];
+    uint32_t _due_us[MAX_DEVICES];
+    uint8_t _device_count;
+
+    uint32_t _period_us;
+    uint32_t _start_us;
+    uint32_t _samples;
+    uint32_t _trigger_skew_us;
+};
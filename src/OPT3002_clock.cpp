@@ -0,0 +1,20 @@
+#include "OPT3002_clock.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+#include <errno.h>
+#include <time.h>
+
+uint32_t OPT3002LinuxClock::now_us() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return uint32_t(uint64_t(now.tv_sec) * 1000000 + now.tv_nsec / 1000);
+}
+
+void OPT3002LinuxClock::sleep_us(uint32_t duration_us) {
+    struct timespec duration;
+    duration.tv_sec = duration_us / 1000000;
+    duration.tv_nsec = long(duration_us % 1000000) * 1000;
+    while (nanosleep(&duration, &duration) != 0 and errno == EINTR) {
+    }
+}
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <stdint.h>
+#endif
+
+/**
+ * Time source for the parts of the library that schedule bus traffic.
+ * Timestamps are in microseconds and wrap at 2^32 like Arduino's micros(),
+ * so intervals must be computed by unsigned subtraction.
+ */
+class OPT3002Clock {
+   public:
+    virtual ~OPT3002Clock() {}
+
+    // Monotonic time in microseconds
+    virtual uint32_t now_us() = 0;
+
+    // Block for (at least) the given number of microseconds
+    virtual void sleep_us(uint32_t duration_us) = 0;
+};
+
+// True if timestamp a is at or after timestamp b, allowing for wrap-around
+inline bool opt3002_time_reached(uint32_t a, uint32_t b) { return int32_t(a - b) >= 0; }
+
+#if defined(ARDUINO)
+/**
+ * Clock backed by micros() and delay()/delayMicroseconds().
+ */
+class OPT3002ArduinoClock : public OPT3002Clock {
+   public:
+    uint32_t now_us() { return micros(); }
+    void sleep_us(uint32_t duration_us) {
+        // delayMicroseconds() is only accurate up to ~16ms
+        delay(duration_us / 1000);
+        delayMicroseconds(duration_us % 1000);
+    }
+};
+#endif
+
+#if defined(__linux__) && !defined(ARDUINO)
+/**
+ * Clock backed by CLOCK_MONOTONIC.
+ */
+class OPT3002LinuxClock : public OPT3002Clock {
+   public:
+    uint32_t now_us();
+    void sleep_us(uint32_t duration_us);
+};
+#endif
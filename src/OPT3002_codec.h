@@ -0,0 +1,108 @@
+#pragma once
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <stdint.h>
+#endif
+
+/**
+ * Explicit encoding of the sensor's 16-bit registers.
+ *
+ * The opt3002_config_t and opt3002_result_t unions describe the registers
+ * with bitfields, whose layout is up to the compiler and ABI. These helpers
+ * use shifts and masks on the raw word instead, so the result is the same
+ * on every compiler, and every one of them is constexpr.
+ *
+ * Field layout, from the OPT3002 datasheet:
+ *
+ *   RESULT / LOW_LIMIT / HIGH_LIMIT
+ *     15:12 E    exponent
+ *     11:0  R    mantissa
+ *
+ *   CONFIG
+ *     15:12 RN   range (0-11 manual, 12 auto)
+ *     11    CT   conversion time (0: 100ms, 1: 800ms)
+ *     10:9  M    mode (00 shutdown, 01 single-shot, 10/11 continuous)
+ *     8     OVF  overflow flag (read-only)
+ *     7     CRF  conversion ready flag (read-only)
+ *     6     FH   flag high (read-only)
+ *     5     FL   flag low (read-only)
+ *     4     L    latch
+ *     3     POL  INT polarity (1: active high)
+ *     2     ME   mask exponent
+ *     1:0   FC   fault count
+ *
+ * On the wire every register is sent most significant byte first.
+ */
+
+// RESULT, LOW_LIMIT and HIGH_LIMIT
+constexpr uint16_t opt3002_result_encode(uint8_t exponent, uint16_t mantissa) {
+    return uint16_t((exponent & 0x0F) << 12 | (mantissa & 0x0FFF));
+}
+constexpr uint8_t opt3002_result_exponent(uint16_t word) { return word >> 12; }
+constexpr uint16_t opt3002_result_mantissa(uint16_t word) { return word & 0x0FFF; }
+
+// CONFIG field positions and masks
+const uint8_t OPT3002_CONFIG_RANGE_SHIFT = 12;
+const uint8_t OPT3002_CONFIG_CONVERSION_TIME_SHIFT = 11;
+const uint8_t OPT3002_CONFIG_MODE_SHIFT = 9;
+const uint16_t OPT3002_CONFIG_RANGE_MASK = 0xF000;
+const uint16_t OPT3002_CONFIG_CONVERSION_TIME_MASK = 0x0800;
+const uint16_t OPT3002_CONFIG_MODE_MASK = 0x0600;
+const uint16_t OPT3002_CONFIG_OVERFLOW = 0x0100;
+const uint16_t OPT3002_CONFIG_CONVERSION_READY = 0x0080;
+const uint16_t OPT3002_CONFIG_FLAG_HIGH = 0x0040;
+const uint16_t OPT3002_CONFIG_FLAG_LOW = 0x0020;
+const uint16_t OPT3002_CONFIG_LATCH = 0x0010;
+const uint16_t OPT3002_CONFIG_POLARITY = 0x0008;
+const uint16_t OPT3002_CONFIG_MASK_EXPONENT = 0x0004;
+const uint16_t OPT3002_CONFIG_FAULT_COUNT_MASK = 0x0003;
+
+// Build a CONFIG word from its writable fields
+constexpr uint16_t opt3002_config_encode(uint8_t range, uint8_t conversion_time, uint8_t mode, bool latch, bool active_high,
+                                         bool mask_exponent, uint8_t fault_count) {
+    return uint16_t((range & 0x0F) << OPT3002_CONFIG_RANGE_SHIFT | (conversion_time & 0x01) << OPT3002_CONFIG_CONVERSION_TIME_SHIFT |
+                    (mode & 0x03) << OPT3002_CONFIG_MODE_SHIFT | (latch ? OPT3002_CONFIG_LATCH : 0) |
+                    (active_high ? OPT3002_CONFIG_POLARITY : 0) | (mask_exponent ? OPT3002_CONFIG_MASK_EXPONENT : 0) |
+                    (fault_count & OPT3002_CONFIG_FAULT_COUNT_MASK));
+}
+
+// Read CONFIG fields
+constexpr uint8_t opt3002_config_range(uint16_t word) { return word >> OPT3002_CONFIG_RANGE_SHIFT; }
+constexpr uint8_t opt3002_config_conversion_time(uint16_t word) { return (word & OPT3002_CONFIG_CONVERSION_TIME_MASK) >> OPT3002_CONFIG_CONVERSION_TIME_SHIFT; }
+constexpr uint8_t opt3002_config_mode(uint16_t word) { return (word & OPT3002_CONFIG_MODE_MASK) >> OPT3002_CONFIG_MODE_SHIFT; }
+constexpr uint8_t opt3002_config_fault_count(uint16_t word) { return word & OPT3002_CONFIG_FAULT_COUNT_MASK; }
+constexpr bool opt3002_config_flag(uint16_t word, uint16_t flag) { return (word & flag) != 0; }
+
+// Replace one field of a CONFIG word
+constexpr uint16_t opt3002_config_with(uint16_t word, uint16_t mask, uint8_t shift, uint8_t value) {
+    return uint16_t((word & ~mask) | ((uint16_t(value) << shift) & mask));
+}
+constexpr uint16_t opt3002_config_with_flag(uint16_t word, uint16_t flag, bool set) { return uint16_t(set ? (word | flag) : (word & ~flag)); }
+
+// Wire order: most significant byte first
+inline void opt3002_pack(uint16_t word, uint8_t *bytes) {
+    bytes[0] = word >> 8;
+    bytes[1] = word & 0xFF;
+}
+constexpr uint16_t opt3002_unpack(uint8_t first, uint8_t second) { return uint16_t(first) << 8 | second; }
+
+// Checked against the datasheet by every compiler that builds the library
+static_assert(opt3002_config_encode(12, 1, 0, true, false, false, 0) == 0xC810, "CONFIG power-on value");
+static_assert(opt3002_config_range(0xC810) == 12, "RN field");
+static_assert(opt3002_config_conversion_time(0xC810) == 1, "CT field");
+static_assert(opt3002_config_mode(0xC810) == 0, "M field");
+static_assert(opt3002_config_flag(0xC810, OPT3002_CONFIG_LATCH), "L field");
+static_assert(opt3002_config_mode(0x0400) == 2 and opt3002_config_mode(0x0200) == 1, "M field position");
+static_assert(opt3002_config_encode(0, 0, 0, false, true, true, 3) == 0x000F, "POL, ME and FC fields");
+static_assert(opt3002_config_flag(0x0100, OPT3002_CONFIG_OVERFLOW) and opt3002_config_flag(0x0080, OPT3002_CONFIG_CONVERSION_READY),
+              "OVF and CRF fields");
+static_assert(opt3002_config_flag(0x0040, OPT3002_CONFIG_FLAG_HIGH) and opt3002_config_flag(0x0020, OPT3002_CONFIG_FLAG_LOW), "FH and FL fields");
+static_assert((OPT3002_CONFIG_OVERFLOW | OPT3002_CONFIG_CONVERSION_READY | OPT3002_CONFIG_FLAG_HIGH | OPT3002_CONFIG_FLAG_LOW) == 0x01E0,
+              "Read-only CONFIG bits");
+static_assert(opt3002_config_with(0xC810, OPT3002_CONFIG_MODE_MASK, OPT3002_CONFIG_MODE_SHIFT, 2) == 0xCC10, "Setting M");
+static_assert(opt3002_config_with(0xC810, OPT3002_CONFIG_RANGE_MASK, OPT3002_CONFIG_RANGE_SHIFT, 3) == 0x3810, "Setting RN");
+static_assert(opt3002_result_encode(11, 0x0FFF) == 0xBFFF, "HIGH_LIMIT power-on value");
+static_assert(opt3002_result_exponent(0x6456) == 6 and opt3002_result_mantissa(0x6456) == 0x0456, "RESULT fields");
+static_assert(opt3002_unpack(0x54, 0x49) == 0x5449, "Manufacturer ID byte order");
@@ -0,0 +1,209 @@
+#include "OPT3002_compress.h"
+
+// Prefix lengths of the longest codes, which end without a 0
+static const uint8_t TIME_PREFIX_MAX = 4;
+static const uint8_t VALUE_PREFIX_MAX = 5;
+
+// Payload widths for each prefix length (number of leading 1s)
+static const uint8_t TIME_WIDTHS[TIME_PREFIX_MAX + 1] = {0, 7, 12, 20, 32};
+static const uint8_t VALUE_WIDTHS[VALUE_PREFIX_MAX + 1] = {0, 3, 5, 11, 9, 16};
+
+static uint32_t zigzag(int32_t value) { return (uint32_t(value) << 1) ^ uint32_t(value >> 31); }
+static int32_t unzigzag(uint32_t value) { return int32_t(value >> 1) ^ -int32_t(value & 1); }
+
+// Width a zigzag value needs from the given table, as its prefix length
+static uint8_t bucket(uint32_t zigzagged, const uint8_t *widths, uint8_t last) {
+    for (uint8_t ones = 1; ones < last; ones++) {
+        if (zigzagged < (uint32_t(1) << widths[ones])) return ones;
+    }
+    return last;
+}
+
+// Mantissa the previous word would have if read at another exponent
+static int32_t rescale(uint16_t word, uint8_t exponent) {
+    int32_t mantissa = opt3002_result_mantissa(word);
+    uint8_t previous = opt3002_result_exponent(word);
+    return exponent > previous ? mantissa >> 1 : mantissa << 1;
+}
+
+/**
+ * One code to append: a prefix of ones (ended by a 0 unless it is the
+ * longest) and a payload.
+ */
+typedef struct {
+    uint8_t ones;
+    uint8_t prefix_length;
+    uint32_t payload;
+    uint8_t payload_length;
+} code_t;
+
+static code_t make_code(uint8_t ones, uint8_t max_ones, uint32_t payload, uint8_t payload_length) {
+    code_t code;
+    code.ones = ones;
+    code.prefix_length = ones < max_ones ? ones + 1 : ones;
+    code.payload = payload;
+    code.payload_length = payload_length;
+    return code;
+}
+
+OPT3002SampleEncoder::OPT3002SampleEncoder(uint8_t *buffer, size_t capacity)
+    : _buffer(buffer), _capacity(capacity), _count(0), _bits(0), _last_us(0), _last_delta_us(0), _last_word(0) {
+    reset();
+}
+
+void OPT3002SampleEncoder::reset() {
+    _count = 0;
+    _bits = OPT3002_PACKET_HEADER_SIZE * 8;
+    _last_delta_us = 0;
+}
+
+void OPT3002SampleEncoder::put_bits(uint32_t value, uint8_t length) {
+    while (length > 0) {
+        uint8_t offset = _bits & 7;
+        uint8_t room = 8 - offset;
+        uint8_t take = length < room ? length : room;
+        uint8_t chunk = uint8_t(value >> (length - take)) & ((1 << take) - 1);
+
+        uint8_t &byte = _buffer[_bits >> 3];
+        if (offset == 0) byte = 0;
+        byte |= chunk << (room - take);
+
+        _bits += take;
+        length -= take;
+    }
+}
+
+/**
+ * Append a sample, choosing the shortest timestamp and value codes.
+ * Both codes are worked out before anything is written, so a sample that
+ * would overrun the buffer is refused whole.
+ */
+bool OPT3002SampleEncoder::add(uint32_t timestamp_us, opt3002_result_t result) {
+    if (_count == 0xFFFF) return false;
+
+    uint16_t word = result.raw;
+    if (_count == 0) {
+        if (_bits + 48 > _capacity * 8) return false;
+        put_bits(timestamp_us, 32);
+        put_bits(word, 16);
+    } else {
+        uint32_t delta_us = timestamp_us - _last_us;
+        uint32_t time_zigzag = zigzag(int32_t(delta_us - _last_delta_us));
+        uint8_t time_ones = time_zigzag == 0 ? 0 : bucket(time_zigzag, TIME_WIDTHS, TIME_PREFIX_MAX);
+        code_t time = make_code(time_ones, TIME_PREFIX_MAX, time_zigzag, TIME_WIDTHS[time_ones]);
+
+        code_t value;
+        uint16_t difference = word ^ _last_word;
+        uint8_t exponent = opt3002_result_exponent(word);
+        uint8_t last_exponent = opt3002_result_exponent(_last_word);
+        int32_t mantissa = opt3002_result_mantissa(word);
+        if (difference == 0) {
+            value = make_code(0, VALUE_PREFIX_MAX, 0, 0);
+        } else if (opt3002_result_exponent(difference) == 0) {
+            uint32_t change = zigzag(mantissa - opt3002_result_mantissa(_last_word));
+            uint8_t ones = bucket(change, VALUE_WIDTHS, 4);
+            value = ones < 4 ? make_code(ones, VALUE_PREFIX_MAX, change, VALUE_WIDTHS[ones]) : make_code(5, VALUE_PREFIX_MAX, word, 16);
+        } else {
+            uint32_t change = zigzag(mantissa - rescale(_last_word, exponent));
+            bool adjacent = exponent == last_exponent + 1 or exponent + 1 == last_exponent;
+            if (adjacent and change < (uint32_t(1) << 8)) {
+                uint32_t down = exponent < last_exponent;
+                value = make_code(4, VALUE_PREFIX_MAX, down << 8 | change, VALUE_WIDTHS[4]);
+            } else {
+                value = make_code(5, VALUE_PREFIX_MAX, word, 16);
+            }
+        }
+
+        uint32_t length = time.prefix_length + time.payload_length + value.prefix_length + value.payload_length;
+        if (_bits + length > _capacity * 8) return false;
+
+        put_bits((uint32_t(1) << time.ones) - 1, time.ones);
+        if (time.prefix_length > time.ones) put_bits(0, 1);
+        put_bits(time.payload, time.payload_length);
+        put_bits((uint32_t(1) << value.ones) - 1, value.ones);
+        if (value.prefix_length > value.ones) put_bits(0, 1);
+        put_bits(value.payload, value.payload_length);
+        _last_delta_us = delta_us;
+    }
+
+    _last_us = timestamp_us;
+    _last_word = word;
+    _count++;
+    return true;
+}
+
+size_t OPT3002SampleEncoder::finish() {
+    _buffer[0] = _count & 0xFF;
+    _buffer[1] = _count >> 8;
+    return (_bits + 7) >> 3;
+}
+
+OPT3002SampleDecoder::OPT3002SampleDecoder(const uint8_t *packet, size_t length)
+    : _packet(packet), _length(length), _count(0), _index(0), _position(OPT3002_PACKET_HEADER_SIZE * 8), _last_us(0), _last_delta_us(0), _last_word(0) {
+    if (length >= OPT3002_PACKET_HEADER_SIZE) _count = uint16_t(packet[0]) | uint16_t(packet[1]) << 8;
+}
+
+bool OPT3002SampleDecoder::get_bits(uint8_t length, uint32_t &value) {
+    if (_position + length > _length * 8) return false;
+
+    value = 0;
+    while (length > 0) {
+        uint8_t offset = _position & 7;
+        uint8_t room = 8 - offset;
+        uint8_t take = length < room ? length : room;
+        uint8_t chunk = (_packet[_position >> 3] >> (room - take)) & ((1 << take) - 1);
+
+        // Two shifts, as a shift by 32 is undefined
+        value = (value << (take - 1) << 1) | chunk;
+        _position += take;
+        length -= take;
+    }
+    return true;
+}
+
+// Count leading 1s up to max_ones, consuming the 0 after them. 0xFF if truncated.
+uint8_t OPT3002SampleDecoder::get_prefix(uint8_t max_ones) {
+    uint8_t ones = 0;
+    uint32_t bit;
+    while (ones < max_ones) {
+        if (not get_bits(1, bit)) return 0xFF;
+        if (not bit) break;
+        ones++;
+    }
+    return ones;
+}
+
+bool OPT3002SampleDecoder::next(uint32_t &timestamp_us, opt3002_result_t &result) {
+    if (_index >= _count) return false;
+
+    uint32_t value;
+    if (_index == 0) {
+        uint32_t word;
+        if (not get_bits(32, value) or not get_bits(16, word)) return false;
+        _last_us = value;
+        _last_word = word;
+    } else {
+        uint8_t ones = get_prefix(TIME_PREFIX_MAX);
+        if (ones == 0xFF or not get_bits(TIME_WIDTHS[ones], value)) return false;
+        _last_delta_us += unzigzag(value);
+        _last_us += _last_delta_us;
+
+        ones = get_prefix(VALUE_PREFIX_MAX);
+        if (ones == 0xFF or not get_bits(VALUE_WIDTHS[ones], value)) return false;
+        if (ones == 5) {
+            _last_word = value;
+        } else if (ones == 4) {
+            uint8_t exponent = opt3002_result_exponent(_last_word);
+            exponent = value >> 8 ? exponent - 1 : exponent + 1;
+            int32_t mantissa = rescale(_last_word, exponent) + unzigzag(value & 0xFF);
+            _last_word = opt3002_result_encode(exponent, mantissa);
+        } else if (ones > 0) {
+            _last_word += unzigzag(value);
+        }
+    }
+
+    timestamp_us = _last_us;
+    result.raw = _last_word;
+    _index++;
+    return true;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "OPT3002.h"
+
+/**
+ * Gorilla-style compression of one sensor's samples into small packets.
+ *
+ * A packet is a 16-bit sample count (little-endian) followed by a bit stream,
+ * most significant bit first. The first sample is stored whole: a 32-bit
+ * timestamp in us and the 16-bit result word. Every later sample stores a
+ * timestamp code and then a value code.
+ *
+ *   Timestamp: delta-of-delta of the sample times, D = (t - t') - (t' - t'')
+ *     0                       D == 0
+ *     10   + 7 bits zigzag    -64 to 63 us
+ *     110  + 12 bits zigzag   -2048 to 2047 us
+ *     1110 + 20 bits zigzag   about +-0.5 s
+ *     1111 + 32 bits          anything else
+ *   The delta before the second sample counts as 0.
+ *
+ *   Value: the XOR of the result word with the previous one has its top four
+ *   bits clear exactly when the exponent is unchanged. Then the mantissa
+ *   difference M = R - R' is stored, as mantissas are plain integers (there is
+ *   no sign or implicit bit for an XOR to skip, as there is in a float):
+ *     0                       same word
+ *     10   + 3 bits zigzag    -4 to 3
+ *     110  + 5 bits zigzag    -16 to 15
+ *     1110 + 11 bits zigzag   -1024 to 1023
+ *   If the exponent moved by one, R' is first rescaled to the new exponent
+ *   (doubled or halved), which is where an auto-range switch lands it:
+ *     11110 + 1 bit (0: up, 1: down) + 8 bits zigzag    -128 to 127
+ *   Anything else is stored whole:
+ *     11111 + 16 bits
+ *
+ * Samples on schedule whose light has not moved cost two bits. Both sides keep
+ * a few words of state and work in the caller's buffer, so they need no heap
+ * and run on MCUs as well as hosts.
+ */
+
+const size_t OPT3002_PACKET_HEADER_SIZE = 2;
+
+/**
+ * Packs samples into a packet buffer until it is full.
+ *
+ * Example:
+ *   uint8_t packet[51];
+ *   OPT3002SampleEncoder encoder(packet, sizeof(packet));
+ *   ...
+ *   if (not encoder.add(sample)) {
+ *       radio.send(packet, encoder.finish());
+ *       encoder.reset();
+ *       encoder.add(sample);
+ *   }
+ */
+class OPT3002SampleEncoder {
+   public:
+    OPT3002SampleEncoder(uint8_t *buffer, size_t capacity);
+
+    // Start a new, empty packet in the buffer
+    void reset();
+
+    // Append a sample. Returns false, leaving the packet as it was, if the
+    // sample does not fit.
+    bool add(uint32_t timestamp_us, opt3002_result_t result);
+    bool add(const opt3002_sample_t &sample) { return add(sample.timestamp_us, sample.result); }
+
+    // Write the sample count; returns the bytes of the packet to send
+    size_t finish();
+
+    uint16_t get_count() const { return _count; }
+    uint32_t get_bits() const { return _bits; }
+
+   private:
+    uint8_t *_buffer;
+    size_t _capacity;
+
+    uint16_t _count;
+    uint32_t _bits;  // Used so far, including the header
+
+    uint32_t _last_us;
+    uint32_t _last_delta_us;
+    uint16_t _last_word;
+
+    void put_bits(uint32_t value, uint8_t length);
+};
+
+/**
+ * Unpacks a packet made by OPT3002SampleEncoder.
+ */
+class OPT3002SampleDecoder {
+   public:
+    // The packet must outlive the decoder
+    OPT3002SampleDecoder(const uint8_t *packet, size_t length);
+
+    // Samples in the packet; 0 if it is too short to hold its header
+    uint16_t get_count() const { return _count; }
+
+    // Next sample. Returns false after the last one or if the packet is truncated.
+    bool next(uint32_t &timestamp_us, opt3002_result_t &result);
+
+   private:
+    const uint8_t *_packet;
+    size_t _length;
+
+    uint16_t _count;
+    uint16_t _index;
+    uint32_t _position;  // Bit offset of the next code
+
+    uint32_t _last_us;
+    uint32_t _last_delta_us;
+    uint16_t _last_word;
+
+    bool get_bits(uint8_t length, uint32_t &value);
+    uint8_t get_prefix(uint8_t max_ones);
+};
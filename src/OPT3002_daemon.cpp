@@ -0,0 +1,91 @@
+#include "OPT3002_daemon.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+OPT3002Daemon::~OPT3002Daemon() {
+    stop();
+    for (uint8_t i = 0; i < _bus_count; i++) delete _workers[i];
+}
+
+bool OPT3002Daemon::add_bus(OPT3002Transport &transport, OPT3002Clock &clock) {
+    if (_running or _bus_count >= MAX_BUSES) return false;
+    _workers[_bus_count++] = new Worker(transport, clock);
+    return true;
+}
+
+/**
+ * Bring up every bus and launch one worker thread per bus.
+ * Buses where no sensor answers get no thread.
+ */
+uint8_t OPT3002Daemon::start(opt3002_conv_time_t conversion_time, opt3002_range_t range) {
+    if (_running) return 0;
+
+    uint8_t found = 0;
+    for (uint8_t i = 0; i < _bus_count; i++) {
+        Worker &worker = *_workers[i];
+        if (worker.bus.get_device_count() == 0) worker.bus.begin();
+        if (worker.bus.get_device_count() == 0) continue;
+        worker.bus.start(conversion_time, range);
+        found += worker.bus.get_device_count();
+    }
+
+    _running = true;
+    for (uint8_t i = 0; i < _bus_count; i++) {
+        Worker &worker = *_workers[i];
+        if (worker.bus.get_device_count() == 0) continue;
+        worker.thread = std::thread(&OPT3002Daemon::run, this, std::ref(worker));
+    }
+    return found;
+}
+
+void OPT3002Daemon::stop() {
+    if (not _running) return;
+    _running = false;
+
+    for (uint8_t i = 0; i < _bus_count; i++) {
+        Worker &worker = *_workers[i];
+        if (worker.thread.joinable()) worker.thread.join();
+        worker.bus.stop();
+    }
+}
+
+/**
+ * Worker loop: read whatever is due, then sleep until the next deadline.
+ */
+void OPT3002Daemon::run(Worker &worker) {
+    while (_running) {
+        worker.bus.service(on_sample, &worker);
+
+        uint32_t wait_us = worker.bus.time_until_due();
+        if (wait_us > STOP_POLL_US) wait_us = STOP_POLL_US;
+        if (wait_us) worker.clock->sleep_us(wait_us);
+    }
+}
+
+void OPT3002Daemon::on_sample(const opt3002_sample_t &sample, void *context) {
+    Worker *worker = (Worker *)context;
+    worker->queue.push(sample);
+    worker->samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Take a sample from the next bus that has one, starting after the bus the
+ * previous sample came from so that no bus can starve the others.
+ */
+bool OPT3002Daemon::pop(opt3002_sample_t &sample, uint8_t &bus_index) {
+    for (uint8_t checked = 0; checked < _bus_count; checked++) {
+        uint8_t index = _next_bus;
+        _next_bus = _next_bus + 1 < _bus_count ? _next_bus + 1 : 0;
+        if (_workers[index]->queue.pop(sample)) {
+            bus_index = index;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t OPT3002Daemon::get_device_count(uint8_t bus_index) const { return _workers[bus_index]->bus.get_device_count(); }
+
+uint32_t OPT3002Daemon::get_samples(uint8_t bus_index) const { return _workers[bus_index]->samples.load(std::memory_order_relaxed); }
+
+uint32_t OPT3002Daemon::get_overruns(uint8_t bus_index) const { return _workers[bus_index]->queue.get_overruns(); }
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "OPT3002_bus.h"
+#include "OPT3002_ring.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+#include <atomic>
+#include <thread>
+
+/**
+ * Continuous acquisition from several I2C buses, one worker thread per bus.
+ *
+ * Each worker owns an OPT3002Bus, which reads its sensors as their
+ * conversions fall due and sleeps until the next deadline in between, so a
+ * worker blocked on a slow bus never delays another bus. Every worker hands
+ * its samples to the consumer through its own lock-free SPSC ring; pop()
+ * visits the rings in turn. Workers share no locks or counters, so adding a
+ * bus adds a thread and a ring and nothing else.
+ *
+ * Buses are added before start(). The transport and clock of a bus are only
+ * used by its worker thread once started.
+ */
+class OPT3002Daemon {
+   public:
+    static const uint8_t MAX_BUSES = 16;
+    static const size_t QUEUE_CAPACITY = 256;
+
+    OPT3002Daemon() : _bus_count(0), _running(false), _next_bus(0) {}
+    ~OPT3002Daemon();
+
+    // Register a bus. Returns false once MAX_BUSES is reached or while running.
+    bool add_bus(OPT3002Transport &transport, OPT3002Clock &clock);
+
+    // Probe every bus, start continuous conversions and launch the workers.
+    // Returns the number of sensors found.
+    uint8_t start(opt3002_conv_time_t conversion_time = OPT3002_CONV_TIME_100MS, opt3002_range_t range = OPT3002_RANGE_AUTO);
+
+    // Stop the workers and shut the sensors down
+    void stop();
+
+    bool is_running() const { return _running; }
+
+    // Consumer: take the next sample from any bus. Only one thread may consume.
+    bool pop(opt3002_sample_t &sample, uint8_t &bus_index);
+
+    uint8_t get_bus_count() const { return _bus_count; }
+    uint8_t get_device_count(uint8_t bus_index) const;
+
+    // Samples read by a bus's worker, and those dropped because its queue was full
+    uint32_t get_samples(uint8_t bus_index) const;
+    uint32_t get_overruns(uint8_t bus_index) const;
+
+   private:
+    // Longest a worker sleeps before checking for stop()
+    static const uint32_t STOP_POLL_US = 20000;
+
+    struct Worker {
+        Worker(OPT3002Transport &transport, OPT3002Clock &clock) : bus(transport, clock), clock(&clock), samples(0) {}
+
+        OPT3002Bus bus;
+        OPT3002Clock *clock;
+        OPT3002SampleRing<QUEUE_CAPACITY, uint16_t> queue;
+        std::atomic<uint32_t> samples;
+        std::thread thread;
+    };
+
+    Worker *_workers[MAX_BUSES];
+    uint8_t _bus_count;
+    std::atomic<bool> _running;
+    uint8_t _next_bus;
+
+    void run(Worker &worker);
+    static void on_sample(const opt3002_sample_t &sample, void *context);
+};
+#endif
@@ -0,0 +1,83 @@
+#include "OPT3002_gpio.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+OPT3002InterruptLine::~OPT3002InterruptLine() { close(); }
+
+/**
+ * Request edge events on a GPIO line.
+ * The active-low INT output is watched for falling edges, active-high for
+ * rising edges. The line file descriptor is made non-blocking so consume()
+ * can drain it.
+ */
+bool OPT3002InterruptLine::open_gpio(const char *chip_path, uint32_t line, opt3002_interrupt_polarity_t polarity) {
+    close();
+    int chip = ::open(chip_path, O_RDONLY | O_CLOEXEC);
+    if (chip < 0) return false;
+
+    struct gpioevent_request request;
+    memset(&request, 0, sizeof(request));
+    request.lineoffset = line;
+    request.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    request.eventflags = polarity == OPT3002_ACTIVE_HIGH ? GPIOEVENT_REQUEST_RISING_EDGE : GPIOEVENT_REQUEST_FALLING_EDGE;
+    strncpy(request.consumer_label, "opt3002", sizeof(request.consumer_label) - 1);
+
+    int result = ioctl(chip, GPIO_GET_LINEEVENT_IOCTL, &request);
+    ::close(chip);
+    if (result < 0) return false;
+
+    _fd = request.fd;
+    _is_eventfd = false;
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+bool OPT3002InterruptLine::open_eventfd() {
+    close();
+    _fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    _is_eventfd = true;
+    return _fd >= 0;
+}
+
+void OPT3002InterruptLine::close() {
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;
+}
+
+bool OPT3002InterruptLine::signal() {
+    if (_fd < 0 or not _is_eventfd) return false;
+    uint64_t one = 1;
+    return ::write(_fd, &one, sizeof(one)) == sizeof(one);
+}
+
+bool OPT3002InterruptLine::wait(int timeout_ms) {
+    if (_fd < 0) return false;
+    struct pollfd descriptor;
+    descriptor.fd = _fd;
+    descriptor.events = POLLIN;
+    descriptor.revents = 0;
+    return poll(&descriptor, 1, timeout_ms) > 0 and (descriptor.revents & POLLIN);
+}
+
+uint32_t OPT3002InterruptLine::consume() {
+    if (_fd < 0) return 0;
+
+    if (_is_eventfd) {
+        uint64_t count = 0;
+        if (::read(_fd, &count, sizeof(count)) != sizeof(count)) return 0;
+        return uint32_t(count);
+    }
+
+    uint32_t count = 0;
+    struct gpioevent_data event;
+    while (::read(_fd, &event, sizeof(event)) == sizeof(event)) count++;
+    return count;
+}
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "OPT3002.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+/**
+ * Source of INT pin edges on a Linux host.
+ *
+ * Either a real GPIO line requested through the gpio-cdev character device,
+ * or an eventfd that anything (such as the simulator's pin callback) can
+ * signal in its place. Both expose a file descriptor that becomes readable
+ * when an edge is pending, so the line can sit in a poll()/epoll set.
+ */
+class OPT3002InterruptLine {
+   public:
+    OPT3002InterruptLine() : _fd(-1), _is_eventfd(false) {}
+    ~OPT3002InterruptLine();
+
+    // Request edge events for the asserting edge of a GPIO line, e.g. ("/dev/gpiochip0", 17)
+    bool open_gpio(const char *chip_path, uint32_t line, opt3002_interrupt_polarity_t polarity = OPT3002_ACTIVE_LOW);
+
+    // Use an eventfd in place of a GPIO line
+    bool open_eventfd();
+
+    void close();
+
+    int get_fd() const { return _fd; }
+
+    // Raise an edge on an eventfd line
+    bool signal();
+
+    // Wait for an edge; a negative timeout waits forever. Returns true if one is pending.
+    bool wait(int timeout_ms);
+
+    // Clear pending edges without blocking. Returns how many there were.
+    uint32_t consume();
+
+   private:
+    int _fd;
+    bool _is_eventfd;
+};
+#endif
@@ -0,0 +1,131 @@
+#include "OPT3002_i2cdev.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+OPT3002I2cDevTransport::~OPT3002I2cDevTransport() { close(); }
+
+/**
+ * Open an i2c-dev adapter node.
+ * @param path: Path to the adapter, e.g. "/dev/i2c-1"
+ * @return: True if the node opened and the adapter supports I2C_RDWR.
+ */
+bool OPT3002I2cDevTransport::open(const char *path) {
+    close();
+    _fd = ::open(path, O_RDWR | O_CLOEXEC);
+    if (_fd < 0) return false;
+
+    unsigned long functions = 0;
+    if (ioctl(_fd, I2C_FUNCS, &functions) < 0 or not(functions & I2C_FUNC_I2C)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool OPT3002I2cDevTransport::open(uint8_t bus) {
+    char path[16];
+    snprintf(path, sizeof(path), "/dev/i2c-%u", bus);
+    return open(path);
+}
+
+void OPT3002I2cDevTransport::close() {
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;
+}
+
+bool OPT3002I2cDevTransport::submit(struct i2c_msg *messages, size_t count) {
+    struct i2c_rdwr_ioctl_data data;
+    data.msgs = messages;
+    data.nmsgs = count;
+    return ioctl(_fd, I2C_RDWR, &data) == (int)count;
+}
+
+bool OPT3002I2cDevTransport::transfer(struct i2c_msg *messages, size_t count) {
+    _syscalls++;
+    return submit(messages, count);
+}
+
+bool OPT3002I2cDevTransport::write(uint8_t device_address, const uint8_t *data, size_t length) {
+    struct i2c_msg message = {device_address, 0, (uint16_t)length, (uint8_t *)data};
+    return transfer(&message, 1);
+}
+
+bool OPT3002I2cDevTransport::read(uint8_t device_address, uint8_t *data, size_t length) {
+    struct i2c_msg message = {device_address, I2C_M_RD, (uint16_t)length, data};
+    return transfer(&message, 1);
+}
+
+/**
+ * Write then read with a repeated start, in one ioctl.
+ */
+bool OPT3002I2cDevTransport::write_read(uint8_t device_address, const uint8_t *data, size_t length, uint8_t *output, size_t output_length) {
+    struct i2c_msg messages[2] = {
+        {device_address, 0, (uint16_t)length, (uint8_t *)data},
+        {device_address, I2C_M_RD, (uint16_t)output_length, output},
+    };
+    return transfer(messages, 2);
+}
+
+/**
+ * Read a register from each of several devices.
+ * Each read is a pointer write and a 2-byte read joined by a repeated start;
+ * up to MAX_BATCH of them go out in a single ioctl.
+ *
+ * @param reads: Device and register of each read; values are filled in.
+ * @param count: Number of reads.
+ * @return: False if any ioctl failed.
+ */
+bool OPT3002I2cDevTransport::read_registers(opt3002_register_read_t *reads, size_t count) {
+    struct i2c_msg messages[2 * MAX_BATCH];
+    uint8_t buffers[MAX_BATCH][2];
+    bool success = true;
+
+    for (size_t first = 0; first < count; first += MAX_BATCH) {
+        size_t batch = count - first < MAX_BATCH ? count - first : MAX_BATCH;
+        for (size_t i = 0; i < batch; i++) {
+            opt3002_register_read_t &entry = reads[first + i];
+            messages[2 * i] = {entry.device_address, 0, 1, &entry.register_address};
+            messages[2 * i + 1] = {entry.device_address, I2C_M_RD, 2, buffers[i]};
+        }
+
+        if (not transfer(messages, 2 * batch)) {
+            success = false;
+            continue;
+        }
+        for (size_t i = 0; i < batch; i++) reads[first + i].value = opt3002_unpack(buffers[i][0], buffers[i][1]);
+    }
+    return success;
+}
+
+/**
+ * Read the latest result of several sensors with one ioctl per MAX_BATCH.
+ * The sensors must use this transport. Their cached register pointers are
+ * dropped, since the batch moves the pointers behind their backs.
+ */
+bool OPT3002I2cDevTransport::read_results(OPT3002 *const *sensors, size_t count, opt3002_result_t *results) {
+    opt3002_register_read_t reads[MAX_BATCH];
+    bool success = true;
+
+    for (size_t first = 0; first < count; first += MAX_BATCH) {
+        size_t batch = count - first < MAX_BATCH ? count - first : MAX_BATCH;
+        for (size_t i = 0; i < batch; i++) {
+            reads[i].device_address = sensors[first + i]->get_address();
+            reads[i].register_address = 0x00;  // RESULT
+            sensors[first + i]->forget_register_pointer();
+        }
+
+        if (not read_registers(reads, batch)) {
+            success = false;
+            continue;
+        }
+        for (size_t i = 0; i < batch; i++) results[first + i].raw = reads[i].value;
+    }
+    return success;
+}
+#endif
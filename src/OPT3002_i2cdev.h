@@ -0,0 +1,69 @@
+#pragma once
+
+#include "OPT3002.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+struct i2c_msg;
+
+/**
+ * One register read in a batch: filled in with the value on success.
+ */
+typedef struct {
+    uint8_t device_address;
+    uint8_t register_address;
+    uint16_t value;
+} opt3002_register_read_t;
+
+/**
+ * Transport backed by a Linux /dev/i2c-N node using I2C_RDWR.
+ *
+ * Every transaction is a single ioctl carrying the slave address in the
+ * message, so there is no I2C_SLAVE bookkeeping when several sensors share
+ * the adapter. write_read() sends the pointer write and the read in one
+ * ioctl joined by a repeated start, and read_registers() puts the reads of
+ * many devices into one ioctl.
+ *
+ * The adapter must support I2C_FUNC_I2C (plain SMBus-only adapters do not).
+ */
+class OPT3002I2cDevTransport : public OPT3002Transport {
+   public:
+    // The kernel accepts at most 42 messages per I2C_RDWR, two per register read
+    static const size_t MAX_BATCH = 21;
+
+    OPT3002I2cDevTransport() : _fd(-1), _syscalls(0) {}
+    virtual ~OPT3002I2cDevTransport();
+
+    // Open the adapter by path (e.g. "/dev/i2c-1") or by bus number.
+    // Fails if the adapter cannot do combined transactions.
+    bool open(const char *path);
+    bool open(uint8_t bus);
+    void close();
+
+    bool is_open() const { return _fd >= 0; }
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length);
+    bool read(uint8_t device_address, uint8_t *data, size_t length);
+    bool write_read(uint8_t device_address, const uint8_t *data, size_t length, uint8_t *output, size_t output_length);
+
+    // Read one register from each entry, MAX_BATCH entries per ioctl.
+    // Returns false if any transfer failed; the values of that batch are then undefined.
+    bool read_registers(opt3002_register_read_t *reads, size_t count);
+
+    // Read the RESULT register of several sensors on this adapter at once
+    bool read_results(OPT3002 *const *sensors, size_t count, opt3002_result_t *results);
+
+    // Number of I2C_RDWR calls made since construction or reset_counters()
+    uint32_t get_syscalls() const { return _syscalls; }
+    void reset_counters() { _syscalls = 0; }
+
+   protected:
+    // Issue messages as one I2C_RDWR; overridden to run without a kernel
+    virtual bool submit(struct i2c_msg *messages, size_t count);
+
+   private:
+    int _fd;
+    uint32_t _syscalls;
+
+    bool transfer(struct i2c_msg *messages, size_t count);
+};
+#endif
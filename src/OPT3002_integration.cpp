@@ -0,0 +1,100 @@
+#include "OPT3002_integration.h"
+
+// The noise average moves 1/8 of the way to each new value, the trend 1/16
+static const uint8_t NOISE_SHIFT = 3;
+static const uint8_t TREND_SHIFT = 4;
+
+static const int32_t MAX_PPM = 0x0FFFFFFF;
+
+static int32_t clamp_ppm(int64_t value) { return value > MAX_PPM ? MAX_PPM : (value < -MAX_PPM ? -MAX_PPM : int32_t(value)); }
+
+OPT3002IntegrationScheduler::OPT3002IntegrationScheduler(OPT3002 &sensor)
+    : _sensor(&sensor),
+      _conversion_time(OPT3002_CONV_TIME_100MS),
+      _latency_budget_ms(0xFFFFFFFF),
+      _history(0),
+      _last_level(0),
+      _last_delta(0),
+      _last_timestamp_us(0),
+      _trend_ppm_per_s(0),
+      _noise_ppm(NOISE_FLOOR_PPM),
+      _votes(0),
+      _switches(0) {}
+
+bool OPT3002IntegrationScheduler::begin(opt3002_conv_time_t initial) {
+    _history = 0;
+    _votes = 0;
+    _sensor->set_conversion_time(initial);
+    if (not _sensor->commit()) return false;
+    _conversion_time = initial;
+    return true;
+}
+
+/**
+ * Write a conversion time to the sensor. _conversion_time only follows once
+ * the write succeeds, so it always names the time the sensor is using; a
+ * failed write stays staged and is retried by the next call.
+ */
+bool OPT3002IntegrationScheduler::apply(opt3002_conv_time_t conversion_time) {
+    if (conversion_time == _conversion_time and not _sensor->is_config_dirty()) return true;
+    _sensor->set_conversion_time(conversion_time);
+    if (not _sensor->commit()) return false;
+    if (conversion_time == _conversion_time) return true;
+
+    _conversion_time = conversion_time;
+    _switches++;
+
+    // Differences across the switch would mix sample intervals; start again
+    _history = 0;
+    return true;
+}
+
+opt3002_conv_time_t OPT3002IntegrationScheduler::update(const opt3002_sample_t &sample) {
+    if (_latency_budget_ms < 800) {
+        apply(OPT3002_CONV_TIME_100MS);
+        return _conversion_time;
+    }
+
+    uint64_t level = OPT3002::convert_to_pw(sample.result).picowatts;
+    int64_t delta = int64_t(level) - int64_t(_last_level);
+    uint32_t elapsed_us = sample.timestamp_us - _last_timestamp_us;
+
+    uint8_t history = _history;
+    int64_t last_delta = _last_delta;
+    if (_history < 2) _history++;
+    _last_level = level;
+    _last_delta = delta;
+    _last_timestamp_us = sample.timestamp_us;
+    if (history < 2 or level == 0 or elapsed_us == 0) return _conversion_time;
+
+    // Relative change per second
+    int64_t change_ppm = delta * 1000000 / int64_t(level);
+    int32_t rate = clamp_ppm(change_ppm * 1000000 / elapsed_us);
+    _trend_ppm_per_s += (rate - _trend_ppm_per_s) / (1 << TREND_SHIFT);
+
+    // Second difference: the noise of one sample appears in three terms (1, -2, 1),
+    // so the difference is sqrt(6) times the noise. Long conversions see 1/sqrt(8)
+    // of the noise of a short one; scale back up to short-conversion noise.
+    int64_t curvature = delta - last_delta;
+    int64_t noise = (curvature < 0 ? -curvature : curvature) * 1000000 / int64_t(level) * 1000 / 2449;
+    if (_conversion_time == OPT3002_CONV_TIME_800MS) noise = noise * 2828 / 1000;
+    _noise_ppm += (clamp_ppm(noise) - int32_t(_noise_ppm)) / (1 << NOISE_SHIFT);
+
+    uint32_t noise_ppm = _noise_ppm < NOISE_FLOOR_PPM ? NOISE_FLOOR_PPM : _noise_ppm;
+    uint64_t blur_ppm = uint64_t(get_rate_ppm_per_s()) * 800 / 1000;
+
+    opt3002_conv_time_t wanted = _conversion_time;
+    if (blur_ppm < uint64_t(noise_ppm) * STABLE_RATIO) wanted = OPT3002_CONV_TIME_800MS;
+    if (blur_ppm > uint64_t(noise_ppm) * CHANGING_RATIO) wanted = OPT3002_CONV_TIME_100MS;
+
+    // Changing fast is urgent; settle into long conversions only after HOLD
+    // votes. A failed switch keeps its votes so the next sample retries it,
+    // and one no longer wanted is written back to the current time.
+    if (wanted == _conversion_time) {
+        _votes = 0;
+        if (_sensor->is_config_dirty()) apply(wanted);
+    } else if (wanted == OPT3002_CONV_TIME_100MS or ++_votes >= HOLD) {
+        if (apply(wanted)) _votes = 0;
+    }
+    return _conversion_time;
+}
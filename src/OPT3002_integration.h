@@ -0,0 +1,62 @@
+#pragma once
+
+#include "OPT3002.h"
+
+/**
+ * Run-time choice between 100ms and 800ms conversions.
+ *
+ * Each sample updates two running estimates, both relative to the level:
+ *  - the trend (ppm of the level per second), a long average of the first
+ *    differences in which the noise largely cancels
+ *  - the noise of a 100ms conversion (ppm), from second differences, which
+ *    cancel any steady trend
+ * The light drifts by trend * 0.8s during a long conversion. While that blur
+ * stays below STABLE_RATIO times the short conversion's noise, the signal is
+ * noise-limited and the long conversion (sqrt(8) less noise) is used. Once
+ * it exceeds CHANGING_RATIO times that noise, the short conversion is used to
+ * follow the change. The ratio gap and the HOLD count of agreeing samples
+ * before going long form the hysteresis; going short is immediate.
+ *
+ * A latency budget below 800ms pins the short conversion.
+ */
+class OPT3002IntegrationScheduler {
+   public:
+    static const uint8_t STABLE_RATIO = 2;    // Go long while blur < short noise * this
+    static const uint8_t CHANGING_RATIO = 4;  // Go short once blur > short noise * this
+    static const uint8_t HOLD = 4;            // Samples that must agree before switching
+    static const uint32_t NOISE_FLOOR_PPM = 250;
+
+    OPT3002IntegrationScheduler(OPT3002 &sensor);
+
+    // Longest acceptable time from light change to reported sample
+    void set_latency_budget_ms(uint32_t budget_ms) { _latency_budget_ms = budget_ms; }
+
+    // Apply the initial conversion time
+    bool begin(opt3002_conv_time_t initial = OPT3002_CONV_TIME_100MS);
+
+    // Feed each sample; switches the sensor's conversion time when warranted
+    opt3002_conv_time_t update(const opt3002_sample_t &sample);
+
+    opt3002_conv_time_t get_conversion_time() const { return _conversion_time; }
+    uint32_t get_switches() const { return _switches; }
+    uint32_t get_rate_ppm_per_s() const { return _trend_ppm_per_s < 0 ? -_trend_ppm_per_s : _trend_ppm_per_s; }
+    uint32_t get_noise_ppm() const { return _noise_ppm; }
+
+   private:
+    OPT3002 *_sensor;
+    opt3002_conv_time_t _conversion_time;
+    uint32_t _latency_budget_ms;
+
+    uint8_t _history;  // Samples seen since the last switch, up to the two needed for a second difference
+    uint64_t _last_level;
+    int64_t _last_delta;
+    uint32_t _last_timestamp_us;
+
+    int32_t _trend_ppm_per_s;
+    uint32_t _noise_ppm;  // Noise of a 100ms conversion
+
+    uint8_t _votes;
+    uint32_t _switches;
+
+    bool apply(opt3002_conv_time_t conversion_time);
+};
@@ -0,0 +1,325 @@
+#include "OPT3002_log.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static void put_u16(uint8_t *output, uint16_t value) {
+    output[0] = value & 0xFF;
+    output[1] = value >> 8;
+}
+
+static void put_u32(uint8_t *output, uint32_t value) {
+    put_u16(output, value & 0xFFFF);
+    put_u16(output + 2, value >> 16);
+}
+
+static void put_u64(uint8_t *output, uint64_t value) {
+    put_u32(output, uint32_t(value));
+    put_u32(output + 4, uint32_t(value >> 32));
+}
+
+// Longest varint of a 64-bit value
+static const uint8_t MAX_VARINT_BYTES = 10;
+
+// Zigzag-encode a signed value as an LEB128 varint. Returns the bytes written.
+static uint8_t put_varint(uint8_t *output, int64_t value) {
+    uint64_t zigzag = (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+    uint8_t length = 0;
+    while (zigzag >= 0x80) {
+        output[length++] = uint8_t(zigzag) | 0x80;
+        zigzag >>= 7;
+    }
+    output[length++] = uint8_t(zigzag);
+    return length;
+}
+
+static uint32_t period_of(uint16_t config) { return opt3002_config_conversion_time(config) ? 800000UL : 100000UL; }
+
+OPT3002LogWriter::OPT3002LogWriter(opt3002_log_sink_t sink, void *context)
+    : _sink(sink),
+      _context(context),
+      _address(OPT3002_DEFAULT_ADDRESS),
+      _config(OPT3002_CONFIG_RESET),
+      _period_us(period_of(OPT3002_CONFIG_RESET)),
+      _count(0),
+      _payload_bytes(0),
+      _have_time(false),
+      _last_us(0),
+      _last_time_us(0),
+      _bytes_written(0) {}
+
+bool OPT3002LogWriter::begin() {
+    uint8_t header[OPT3002_LOG_FILE_HEADER_SIZE];
+    for (size_t i = 0; i < sizeof(OPT3002_LOG_MAGIC); i++) header[i] = OPT3002_LOG_MAGIC[i];
+    put_u16(header + 8, OPT3002_LOG_VERSION);
+    put_u16(header + 10, OPT3002_LOG_BLOCK_HEADER_SIZE);
+    put_u32(header + 12, 0);
+
+    if (not _sink(header, sizeof(header), _context)) return false;
+    _bytes_written += sizeof(header);
+    return true;
+}
+
+bool OPT3002LogWriter::set_source(uint8_t address, opt3002_config_t config) {
+    // Only the writable fields describe the configuration
+    uint16_t word = config.raw & ~OPT3002_CONFIG_READ_ONLY;
+    if (address == _address and word == _config) return true;
+
+    bool success = flush();
+    _address = address;
+    _config = word;
+    _period_us = period_of(word);
+    return success;
+}
+
+void OPT3002LogWriter::start_block(uint64_t timestamp_us) {
+    put_u16(_block, OPT3002_LOG_BLOCK_MARKER);
+    put_u16(_block + 6, _config);
+    _block[8] = _address;
+    _block[9] = 0;
+    put_u32(_block + 10, _period_us);
+    put_u64(_block + 14, timestamp_us);
+}
+
+/**
+ * Append a sample to the current block, handing the block to the sink first
+ * if the sample might not fit.
+ * @return: False if a full block could not be handed to the sink.
+ */
+bool OPT3002LogWriter::write(const opt3002_sample_t &sample) {
+    bool success = true;
+    if (sample.address != _address) {
+        opt3002_config_t config;
+        config.raw = _config;
+        success = set_source(sample.address, config);
+    }
+
+    uint64_t previous_us = _last_time_us;
+    uint64_t time_us = _have_time ? _last_time_us + uint32_t(sample.timestamp_us - _last_us) : sample.timestamp_us;
+    _have_time = true;
+    _last_us = sample.timestamp_us;
+    _last_time_us = time_us;
+
+    if (_count == 0xFFFF or size_t(_payload_bytes) + MAX_VARINT_BYTES + 2 > MAX_PAYLOAD) success = flush() and success;
+
+    uint8_t *payload = _block + OPT3002_LOG_BLOCK_HEADER_SIZE;
+    int64_t residual = 0;
+    if (_count == 0) {
+        start_block(time_us);
+    } else {
+        residual = int64_t(time_us - previous_us) - int64_t(_period_us);
+    }
+
+    _payload_bytes += put_varint(payload + _payload_bytes, residual);
+    put_u16(payload + _payload_bytes, sample.result.raw);
+    _payload_bytes += 2;
+    _count++;
+    return success;
+}
+
+bool OPT3002LogWriter::flush() {
+    if (_count == 0) return true;
+
+    put_u16(_block + 2, _count);
+    put_u16(_block + 4, _payload_bytes);
+    size_t length = OPT3002_LOG_BLOCK_HEADER_SIZE + _payload_bytes;
+    bool success = _sink(_block, length, _context);
+    if (success) _bytes_written += length;
+
+    _count = 0;
+    _payload_bytes = 0;
+    return success;
+}
+
+#if defined(__linux__) && !defined(ARDUINO)
+static uint16_t get_u16(const uint8_t *input) { return uint16_t(input[0]) | uint16_t(input[1]) << 8; }
+static uint32_t get_u32(const uint8_t *input) { return uint32_t(get_u16(input)) | uint32_t(get_u16(input + 2)) << 16; }
+static uint64_t get_u64(const uint8_t *input) { return uint64_t(get_u32(input)) | uint64_t(get_u32(input + 4)) << 32; }
+
+// Decode a zigzag varint, advancing input. Returns false if it runs past end.
+static bool get_varint(const uint8_t *&input, const uint8_t *end, int64_t &value) {
+    uint64_t zigzag = 0;
+    for (uint8_t shift = 0; shift < 7 * MAX_VARINT_BYTES; shift += 7) {
+        if (input >= end) return false;
+        uint8_t byte = *input++;
+        zigzag |= uint64_t(byte & 0x7F) << shift;
+        if (not(byte & 0x80)) {
+            value = int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+OPT3002LogReader::~OPT3002LogReader() { close(); }
+
+bool OPT3002LogReader::open(const char *path) {
+    close();
+
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat status;
+    void *mapping = MAP_FAILED;
+    if (fstat(fd, &status) == 0 and status.st_size > 0) {
+        mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+    _mapping = mapping;
+    _data = (const uint8_t *)mapping;
+    _size = status.st_size;
+    if (not validate_header()) {
+        close();
+        return false;
+    }
+    rewind();
+    return true;
+}
+
+bool OPT3002LogReader::open(const uint8_t *data, size_t size) {
+    close();
+    _data = data;
+    _size = size;
+    if (not validate_header()) {
+        close();
+        return false;
+    }
+    rewind();
+    return true;
+}
+
+void OPT3002LogReader::close() {
+    if (_mapping != NULL) munmap(_mapping, _size);
+    _mapping = NULL;
+    _data = NULL;
+    _size = 0;
+}
+
+bool OPT3002LogReader::validate_header() {
+    return _size >= OPT3002_LOG_FILE_HEADER_SIZE and memcmp(_data, OPT3002_LOG_MAGIC, sizeof(OPT3002_LOG_MAGIC)) == 0 and
+           get_u16(_data + 8) == OPT3002_LOG_VERSION and get_u16(_data + 10) == OPT3002_LOG_BLOCK_HEADER_SIZE;
+}
+
+void OPT3002LogReader::rewind() {
+    _offset = OPT3002_LOG_FILE_HEADER_SIZE;
+    _block.count = 0;
+    _sample_index = 0;
+}
+
+bool OPT3002LogReader::next_block(opt3002_log_block_t &block) {
+    if (_data == NULL or _size - _offset < OPT3002_LOG_BLOCK_HEADER_SIZE) return false;
+
+    const uint8_t *header = _data + _offset;
+    uint16_t payload_bytes = get_u16(header + 4);
+    if (get_u16(header) != OPT3002_LOG_BLOCK_MARKER) return false;
+    if (payload_bytes > _size - _offset - OPT3002_LOG_BLOCK_HEADER_SIZE) return false;
+
+    block.count = get_u16(header + 2);
+    block.payload_bytes = payload_bytes;
+    block.config.raw = get_u16(header + 6);
+    block.address = header[8];
+    block.period_us = get_u32(header + 10);
+    block.first_timestamp_us = get_u64(header + 14);
+    block.payload = header + OPT3002_LOG_BLOCK_HEADER_SIZE;
+
+    _offset += OPT3002_LOG_BLOCK_HEADER_SIZE + payload_bytes;
+    return true;
+}
+
+// Decode one sample of a block, advancing position and time
+static bool decode_sample(const opt3002_log_block_t &block, uint16_t index, const uint8_t *&position, uint64_t &time_us,
+                          opt3002_log_record_t &record) {
+    const uint8_t *end = block.payload + block.payload_bytes;
+    int64_t residual;
+    if (not get_varint(position, end, residual) or end - position < 2) return false;
+
+    time_us = index == 0 ? block.first_timestamp_us : time_us + block.period_us + residual;
+    record.timestamp_us = time_us;
+    record.result.raw = get_u16(position);
+    record.config = block.config;
+    record.address = block.address;
+    position += 2;
+    return true;
+}
+
+size_t OPT3002LogReader::decode_block(const opt3002_log_block_t &block, opt3002_log_record_t *records, size_t max_count) {
+    const uint8_t *position = block.payload;
+    uint64_t time_us = 0;
+    size_t count = block.count < max_count ? block.count : max_count;
+    for (size_t i = 0; i < count; i++) {
+        if (not decode_sample(block, i, position, time_us, records[i])) return i;
+    }
+    return count;
+}
+
+/**
+ * Decode the next sample, moving to the next block when one runs out.
+ * The rest of a block with a damaged payload is skipped.
+ */
+bool OPT3002LogReader::next(opt3002_log_record_t &record) {
+    while (true) {
+        if (_sample_index >= _block.count) {
+            if (not next_block(_block)) return false;
+            _sample_index = 0;
+            _position = _block.payload;
+        }
+
+        if (decode_sample(_block, _sample_index, _position, _time_us, record)) {
+            _sample_index++;
+            return true;
+        }
+        _sample_index = _block.count;
+    }
+}
+
+/**
+ * Find the last block starting at or before the time from the block headers
+ * alone, then decode forward within it.
+ */
+void OPT3002LogReader::seek(uint64_t timestamp_us) {
+    rewind();
+
+    opt3002_log_block_t block;
+    opt3002_log_block_t candidate;
+    size_t candidate_end = 0;
+    bool found = false;
+    while (next_block(block) and block.first_timestamp_us <= timestamp_us) {
+        candidate = block;
+        candidate_end = _offset;
+        found = true;
+    }
+
+    if (not found) {
+        rewind();
+        return;
+    }
+
+    _block = candidate;
+    _offset = candidate_end;
+    _sample_index = 0;
+    _position = _block.payload;
+
+    while (_sample_index < _block.count) {
+        const uint8_t *position = _position;
+        uint64_t time_us = _time_us;
+        opt3002_log_record_t record;
+        if (not decode_sample(_block, _sample_index, position, time_us, record)) {
+            _sample_index = _block.count;
+            break;
+        }
+        if (record.timestamp_us >= timestamp_us) break;
+
+        _position = position;
+        _time_us = time_us;
+        _sample_index++;
+    }
+}
+#endif
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "OPT3002.h"
+
+/**
+ * Compact binary log of raw OPT3002 samples.
+ *
+ * All fields are little-endian. A log is a 16-byte file header followed by
+ * blocks:
+ *
+ *   File header
+ *     0  char[8]  "OPT3002L"
+ *     8  u16      version (1)
+ *     10 u16      block header size (22)
+ *     12 u32      reserved
+ *
+ *   Block header
+ *     0  u16      marker 0x4B42 ("BK")
+ *     2  u16      number of samples
+ *     4  u16      payload bytes
+ *     6  u16      CONFIG word in effect (range, conversion time, ...)
+ *     8  u8       I2C address of the sensor
+ *     9  u8       reserved
+ *     10 u32      nominal sample period in us (the conversion time)
+ *     14 u64      timestamp of the first sample in us
+ *
+ *   Block payload, per sample
+ *     varint      zigzag(interval from the previous sample - period);
+ *                 0 for the first sample of a block
+ *     u16         raw result word
+ *
+ * Samples taken on schedule cost one timestamp byte, so a sample is three
+ * bytes plus its share of the block header. A block covers one sensor and
+ * one configuration; the writer starts a new block when either changes.
+ */
+typedef struct {
+    uint64_t timestamp_us;
+    opt3002_result_t result;
+    opt3002_config_t config;
+    uint8_t address;
+} opt3002_log_record_t;
+
+const uint8_t OPT3002_LOG_MAGIC[8] = {'O', 'P', 'T', '3', '0', '0', '2', 'L'};
+const uint16_t OPT3002_LOG_VERSION = 1;
+const uint16_t OPT3002_LOG_BLOCK_MARKER = 0x4B42;
+const size_t OPT3002_LOG_FILE_HEADER_SIZE = 16;
+const size_t OPT3002_LOG_BLOCK_HEADER_SIZE = 22;
+
+/**
+ * Destination for finished blocks: a file, an SD card, a radio, ...
+ * Returns false if the data could not be stored.
+ */
+typedef bool (*opt3002_log_sink_t)(const uint8_t *data, size_t length, void *context);
+
+/**
+ * Streaming writer for the log format.
+ * Blocks are assembled in a fixed buffer inside the writer and handed to the
+ * sink whole, so the writer needs no heap and runs on MCUs as well as hosts.
+ */
+class OPT3002LogWriter {
+   public:
+    // Payload space per block; about 80 samples on schedule
+    static const size_t MAX_PAYLOAD = 240;
+
+    OPT3002LogWriter(opt3002_log_sink_t sink, void *context = NULL);
+
+    // Emit the file header. Call once at the start of a new log.
+    bool begin();
+
+    // Describe the sensor the following samples come from. A change ends the
+    // current block; returns false if handing it to the sink failed.
+    bool set_source(uint8_t address, opt3002_config_t config);
+
+    // Append a sample. The 32-bit timestamp is extended to 64 bits across wraps.
+    bool write(const opt3002_sample_t &sample);
+
+    // Hand the current block to the sink, even if it is not full
+    bool flush();
+
+    // Bytes handed to the sink so far
+    uint32_t get_bytes_written() const { return _bytes_written; }
+
+   private:
+    opt3002_log_sink_t _sink;
+    void *_context;
+
+    uint8_t _address;
+    uint16_t _config;
+    uint32_t _period_us;
+
+    uint8_t _block[OPT3002_LOG_BLOCK_HEADER_SIZE + MAX_PAYLOAD];
+    uint16_t _count;
+    uint16_t _payload_bytes;
+
+    bool _have_time;
+    uint32_t _last_us;
+    uint64_t _last_time_us;
+    uint32_t _bytes_written;
+
+    void start_block(uint64_t timestamp_us);
+};
+
+#if defined(__linux__) && !defined(ARDUINO)
+/**
+ * Block header as seen by the reader, with a pointer to the payload.
+ */
+typedef struct {
+    uint64_t first_timestamp_us;
+    uint32_t period_us;
+    uint16_t count;
+    uint16_t payload_bytes;
+    opt3002_config_t config;
+    uint8_t address;
+    const uint8_t *payload;
+} opt3002_log_block_t;
+
+/**
+ * Reader for the log format.
+ *
+ * The file is memory-mapped and nothing is decoded up front: next_block()
+ * steps from header to header using the payload sizes, and samples are
+ * decoded only as next() or decode_block() reaches them. Seeking to a time
+ * touches one header per block.
+ */
+class OPT3002LogReader {
+   public:
+    OPT3002LogReader() : _mapping(NULL), _data(NULL), _size(0), _offset(0), _block(), _sample_index(0), _position(NULL), _time_us(0) {}
+    ~OPT3002LogReader();
+
+    // Map a log file. Fails if it does not start with a valid file header.
+    bool open(const char *path);
+
+    // Read a log already in memory; the buffer must outlive the reader
+    bool open(const uint8_t *data, size_t size);
+
+    void close();
+
+    // Go back to the first block
+    void rewind();
+
+    // Step to the next block without decoding it. False at the end or on a damaged header.
+    bool next_block(opt3002_log_block_t &block);
+
+    // Decode the samples of a block. Returns the number decoded; fewer than
+    // block.count means the payload is damaged.
+    static size_t decode_block(const opt3002_log_block_t &block, opt3002_log_record_t *records, size_t max_count);
+
+    // Next sample in the log, decoding block by block
+    bool next(opt3002_log_record_t &record);
+
+    // Position next() at the first sample at or after a time
+    void seek(uint64_t timestamp_us);
+
+   private:
+    void *_mapping;
+    const uint8_t *_data;
+    size_t _size;
+    size_t _offset;  // Start of the next block header
+
+    opt3002_log_block_t _block;
+    uint16_t _sample_index;
+    const uint8_t *_position;
+    uint64_t _time_us;
+
+    bool validate_header();
+};
+#endif
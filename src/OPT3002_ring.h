@@ -0,0 +1,71 @@
+#pragma once
+
+#include "OPT3002.h"
+
+/**
+ * Fixed-capacity single-producer/single-consumer queue of samples.
+ *
+ * Intended for handing samples from an interrupt handler (or another thread)
+ * to the main loop without disabling interrupts: push() is only called by the
+ * producer and pop()/drain() only by the consumer, and each side finishes in
+ * a bounded number of steps regardless of what the other side is doing.
+ *
+ * The head and tail indices run freely and wrap with their type, so the
+ * capacity must be a power of two that fits in half the index range. The
+ * default 8-bit index keeps every shared access a single byte, which is
+ * atomic on 8-bit MCUs; hosts can use a wider index for bigger rings.
+ * When the ring is full, new samples are dropped and counted as overruns.
+ */
+template <size_t Capacity, typename Index = uint8_t>
+class OPT3002SampleRing {
+    static_assert(Capacity >= 2 and (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(Capacity - 1 <= Index(~Index(0)) / 2, "Index type too small for Capacity");
+
+   public:
+    OPT3002SampleRing() : _head(0), _tail(0), _overruns(0) {}
+
+    // Producer: add a sample. Returns false (and counts an overrun) if full.
+    bool push(const opt3002_sample_t &sample) {
+        Index head = _head;
+        Index tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+        if (Index(head - tail) >= Capacity) {
+            _overruns = _overruns + 1;
+            return false;
+        }
+        _buffer[head & (Capacity - 1)] = sample;
+        __atomic_store_n(&_head, Index(head + 1), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Consumer: remove the oldest sample. Returns false if empty.
+    bool pop(opt3002_sample_t &sample) { return drain(&sample, 1) == 1; }
+
+    // Consumer: remove up to max_count samples in one pass. Returns the number removed.
+    size_t drain(opt3002_sample_t *output, size_t max_count) {
+        Index tail = _tail;
+        Index head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+        size_t count = Index(head - tail);
+        if (count > max_count) count = max_count;
+
+        for (size_t i = 0; i < count; i++) {
+            output[i] = _buffer[Index(tail + i) & (Capacity - 1)];
+        }
+        __atomic_store_n(&_tail, Index(tail + count), __ATOMIC_RELEASE);
+        return count;
+    }
+
+    // Number of samples waiting (exact from the consumer side)
+    size_t size() const { return Index(__atomic_load_n(&_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE)); }
+    bool empty() const { return size() == 0; }
+    static size_t capacity() { return Capacity; }
+
+    // Samples dropped because the ring was full. Written only by the producer;
+    // on 8-bit MCUs read it with the producer's interrupt masked.
+    uint32_t get_overruns() const { return _overruns; }
+
+   private:
+    opt3002_sample_t _buffer[Capacity];
+    Index _head;  // Written by the producer only
+    Index _tail;  // Written by the consumer only
+    volatile uint32_t _overruns;
+};
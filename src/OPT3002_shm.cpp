@@ -0,0 +1,259 @@
+#include "OPT3002_shm.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return uint64_t(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+// POSIX shared memory names start with a slash
+static bool make_name(const char *name, char *output, size_t length) {
+    int written = snprintf(output, length, "%s%s", name[0] == '/' ? "" : "/", name);
+    return written > 0 and size_t(written) < length;
+}
+
+/**
+ * Mark the ring currently under a name as retired, so readers mapping it
+ * know to reopen.
+ * @return: The generation for a ring replacing it; 1 if there was no valid ring.
+ */
+static uint32_t retire(const char *path) {
+    int fd = shm_open(path, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) return 1;
+
+    uint32_t generation = 1;
+    struct stat status;
+    if (fstat(fd, &status) == 0 and size_t(status.st_size) >= sizeof(opt3002_shm_header_t)) {
+        void *mapping = mmap(NULL, sizeof(opt3002_shm_header_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping != MAP_FAILED) {
+            opt3002_shm_header_t *header = (opt3002_shm_header_t *)mapping;
+            if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == OPT3002SamplePublisher::MAGIC and
+                header->version == OPT3002SamplePublisher::VERSION) {
+                generation = header->generation + 1;
+                __atomic_store_n(&header->retired, 1, __ATOMIC_RELEASE);
+            }
+            munmap(mapping, sizeof(opt3002_shm_header_t));
+        }
+    }
+    ::close(fd);
+    return generation;
+}
+
+OPT3002SamplePublisher::~OPT3002SamplePublisher() { close(); }
+
+/**
+ * Create the shared memory object and map it.
+ * An existing ring of the same name is retired and unlinked, never truncated:
+ * readers that still map it keep reading valid memory until they reopen. The
+ * new object is created exclusively, and its magic number is written last, so
+ * a reader attaching during creation sees an invalid ring rather than a
+ * half-initialised one.
+ *
+ * @param name: Name of the ring, e.g. "opt3002" for /dev/shm/opt3002
+ * @param capacity: Number of samples held; rounded up to a power of two.
+ */
+bool OPT3002SamplePublisher::create(const char *name, uint32_t capacity) {
+    close();
+
+    char path[256];
+    if (not make_name(name, path, sizeof(path))) return false;
+
+    uint32_t slots = 2;
+    while (slots < capacity and slots < (uint32_t(1) << 30)) slots <<= 1;
+
+    uint32_t generation = retire(path);
+    shm_unlink(path);
+
+    _size = sizeof(opt3002_shm_header_t) + size_t(slots) * sizeof(opt3002_shm_slot_t);
+    _fd = shm_open(path, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (_fd < 0) return false;
+
+    void *mapping = MAP_FAILED;
+    if (ftruncate(_fd, _size) == 0) mapping = mmap(NULL, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+
+    _header = (opt3002_shm_header_t *)mapping;
+    _slots = (opt3002_shm_slot_t *)(_header + 1);
+    memset(mapping, 0, _size);
+    _header->version = VERSION;
+    _header->slot_size = sizeof(opt3002_shm_slot_t);
+    _header->capacity = slots;
+    _header->generation = generation;
+    __atomic_store_n(&_header->magic, MAGIC, __ATOMIC_RELEASE);
+    return true;
+}
+
+void OPT3002SamplePublisher::close() {
+    if (_header != NULL) munmap(_header, _size);
+    if (_fd >= 0) ::close(_fd);
+    _header = NULL;
+    _slots = NULL;
+    _fd = -1;
+}
+
+void OPT3002SamplePublisher::unlink_ring(const char *name) {
+    char path[256];
+    if (not make_name(name, path, sizeof(path))) return;
+    retire(path);
+    shm_unlink(path);
+}
+
+bool OPT3002SamplePublisher::publish(OPT3002 &sensor) {
+    opt3002_result_t result;
+    if (not sensor.get_result(result)) return false;
+    publish(sensor.get_address(), result);
+    return true;
+}
+
+/**
+ * Write a sample into the next slot.
+ * The slot's sequence goes odd before the data is written and back to even
+ * after, then the published count moves on.
+ */
+void OPT3002SamplePublisher::publish(uint8_t address, opt3002_result_t result) {
+    if (_header == NULL) return;
+
+    opt3002_power_t power = OPT3002::convert_to_pw(result);
+    uint64_t index = _header->published;
+    opt3002_shm_slot_t &slot = _slots[index & (_header->capacity - 1)];
+    uint32_t sequence = slot.sequence;
+
+    __atomic_store_n(&slot.sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&slot.sample.timestamp_ns, monotonic_ns(), __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.sample.picowatts, power.picowatts, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.sample.raw, result.raw, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.sample.address, address, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.sample.saturated, uint8_t(power.saturated), __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot.sequence, sequence + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&_header->published, index + 1, __ATOMIC_RELEASE);
+}
+
+uint64_t OPT3002SamplePublisher::get_published() const {
+    return _header == NULL ? 0 : __atomic_load_n(&_header->published, __ATOMIC_ACQUIRE);
+}
+
+OPT3002SampleSubscriber::~OPT3002SampleSubscriber() { close(); }
+
+/**
+ * Map an existing ring read-only.
+ * @return: False if the ring does not exist or is not a ring of this version.
+ */
+bool OPT3002SampleSubscriber::open(const char *name) {
+    close();
+
+    char path[256];
+    if (not make_name(name, path, sizeof(path))) return false;
+
+    int fd = shm_open(path, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) return false;
+
+    struct stat status;
+    void *mapping = MAP_FAILED;
+    if (fstat(fd, &status) == 0 and size_t(status.st_size) >= sizeof(opt3002_shm_header_t)) {
+        _size = status.st_size;
+        mapping = mmap(NULL, _size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    _header = (const opt3002_shm_header_t *)mapping;
+    _slots = (const opt3002_shm_slot_t *)(_header + 1);
+
+    uint32_t capacity = _header->capacity;
+    bool valid = __atomic_load_n(&_header->magic, __ATOMIC_ACQUIRE) == OPT3002SamplePublisher::MAGIC and
+                 _header->version == OPT3002SamplePublisher::VERSION and _header->slot_size == sizeof(opt3002_shm_slot_t) and
+                 capacity >= 2 and (capacity & (capacity - 1)) == 0 and
+                 _size >= sizeof(opt3002_shm_header_t) + size_t(capacity) * sizeof(opt3002_shm_slot_t);
+    if (not valid) {
+        close();
+        return false;
+    }
+
+    _mask = capacity - 1;
+    _shift = 0;
+    while ((uint32_t(1) << _shift) < capacity) _shift++;
+    _missed = 0;
+    seek_latest();
+    return true;
+}
+
+void OPT3002SampleSubscriber::close() {
+    if (_header != NULL) munmap((void *)_header, _size);
+    _header = NULL;
+    _slots = NULL;
+}
+
+bool OPT3002SampleSubscriber::is_retired() const { return _header != NULL and __atomic_load_n(&_header->retired, __ATOMIC_ACQUIRE) != 0; }
+
+void OPT3002SampleSubscriber::seek_latest() {
+    if (_header == NULL) return;
+    _cursor = __atomic_load_n(&_header->published, __ATOMIC_ACQUIRE);
+}
+
+void OPT3002SampleSubscriber::seek_oldest() {
+    if (_header == NULL) return;
+    uint64_t published = __atomic_load_n(&_header->published, __ATOMIC_ACQUIRE);
+    uint64_t capacity = uint64_t(_mask) + 1;
+    _cursor = published > capacity ? published - capacity : 0;
+}
+
+/**
+ * Copy out the next sample.
+ * A slot is accepted only if its sequence shows it holds this reader's
+ * sample and was not being rewritten during the copy. If the publisher has
+ * lapped the reader, it skips to the oldest sample that is still safe to
+ * read and counts the gap as missed.
+ */
+bool OPT3002SampleSubscriber::read(opt3002_shm_sample_t &sample) {
+    if (_header == NULL) return false;
+
+    uint64_t capacity = uint64_t(_mask) + 1;
+    while (true) {
+        uint64_t published = __atomic_load_n(&_header->published, __ATOMIC_ACQUIRE);
+        if (_cursor >= published) return false;
+        if (published - _cursor > capacity) {
+            // Leave one slot of margin for the write that may be under way
+            uint64_t oldest = published - capacity + 1;
+            _missed += oldest - _cursor;
+            _cursor = oldest;
+        }
+
+        const opt3002_shm_slot_t &slot = _slots[_cursor & _mask];
+        uint32_t expected = uint32_t(((_cursor >> _shift) + 1) << 1);
+
+        uint32_t before = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+        sample.timestamp_ns = __atomic_load_n(&slot.sample.timestamp_ns, __ATOMIC_RELAXED);
+        sample.picowatts = __atomic_load_n(&slot.sample.picowatts, __ATOMIC_RELAXED);
+        sample.raw = __atomic_load_n(&slot.sample.raw, __ATOMIC_RELAXED);
+        sample.address = __atomic_load_n(&slot.sample.address, __ATOMIC_RELAXED);
+        sample.saturated = __atomic_load_n(&slot.sample.saturated, __ATOMIC_RELAXED);
+        sample.reserved = 0;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint32_t after = __atomic_load_n(&slot.sequence, __ATOMIC_RELAXED);
+
+        if (before == expected and after == expected) {
+            _cursor++;
+            return true;
+        }
+
+        // Overwritten under us: count it and try the next one
+        _missed++;
+        _cursor++;
+    }
+}
+#endif
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "OPT3002.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+/**
+ * One sample as stored in the shared ring.
+ */
+typedef struct {
+    uint64_t timestamp_ns;  // CLOCK_MONOTONIC time of publication
+    uint64_t picowatts;     // Optical power in pW/cm^2
+    uint16_t raw;           // Result word the power was converted from
+    uint8_t address;        // I2C address of the sensor
+    uint8_t saturated;      // Non-zero if the reading was at or beyond full scale
+    uint32_t reserved;
+} opt3002_shm_sample_t;
+
+/**
+ * Layout of the shared memory object.
+ * A 128-byte header, whose published count sits alone on the second cache
+ * line, followed by capacity slots of 32 bytes. Each slot carries its own sequence
+ * number: odd while the publisher is writing it, otherwise twice the number
+ * of times it has been filled. Readers copy a slot and keep the copy only if
+ * the sequence was even and unchanged across the copy (a seqlock).
+ *
+ * A ring is never resized or cleared in place. A publisher that replaces it
+ * sets retired in the old object, unlinks the name and creates a new object
+ * with the next generation; readers still mapping the old one keep valid
+ * memory and see retired go non-zero.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t slot_size;
+    uint32_t capacity;    // Power of two
+    uint32_t generation;  // One more than the ring this one replaced
+    uint32_t retired;     // Non-zero once replaced or unlinked
+    uint8_t padding[44];
+    uint64_t published;  // Samples written so far
+    uint8_t padding_end[56];
+} opt3002_shm_header_t;
+
+typedef struct {
+    uint32_t sequence;
+    uint32_t reserved;
+    opt3002_shm_sample_t sample;
+} opt3002_shm_slot_t;
+
+static_assert(sizeof(opt3002_shm_header_t) == 128, "Shared header layout");
+static_assert(sizeof(opt3002_shm_slot_t) == 32, "Shared slot layout");
+
+/**
+ * Writer side of a shared-memory sample ring.
+ *
+ * Creates a POSIX shared memory object (/dev/shm/<name>) holding a ring of
+ * timestamped samples. There is one publisher per ring; it never waits for
+ * readers, and readers that fall a full ring behind skip ahead.
+ */
+class OPT3002SamplePublisher {
+   public:
+    static const uint32_t MAGIC = 0x4F505433;  // 'OPT3'
+    static const uint16_t VERSION = 2;
+
+    OPT3002SamplePublisher() : _header(NULL), _slots(NULL), _size(0), _fd(-1) {}
+    ~OPT3002SamplePublisher();
+
+    // Create (or replace) the ring; capacity is rounded up to a power of two
+    bool create(const char *name, uint32_t capacity = 1024);
+
+    // Unmap; unlink_ring() also retires the ring and removes the name so new readers cannot attach
+    void close();
+    static void unlink_ring(const char *name);
+
+    // Read the sensor's latest result and publish it. Returns false if the read failed.
+    bool publish(OPT3002 &sensor);
+
+    // Publish a result read elsewhere
+    void publish(uint8_t address, opt3002_result_t result);
+
+    uint64_t get_published() const;
+    uint32_t get_generation() const { return _header == NULL ? 0 : _header->generation; }
+
+   private:
+    opt3002_shm_header_t *_header;
+    opt3002_shm_slot_t *_slots;
+    size_t _size;
+    int _fd;
+};
+
+/**
+ * Reader side of a shared-memory sample ring.
+ *
+ * The ring is mapped read-only and read in place: taking a sample is a
+ * couple of loads and a 24-byte copy out of the mapping, with no system call
+ * and no copy through the kernel. Any number of readers can attach, each
+ * with its own position.
+ */
+class OPT3002SampleSubscriber {
+   public:
+    OPT3002SampleSubscriber() : _header(NULL), _slots(NULL), _size(0), _mask(0), _shift(0), _cursor(0), _missed(0) {}
+    ~OPT3002SampleSubscriber();
+
+    // Attach to a ring made by a publisher; starts at the newest sample
+    bool open(const char *name);
+    void close();
+
+    bool is_open() const { return _header != NULL; }
+
+    // True once a publisher has replaced or unlinked the ring; close() and open() again to follow it
+    bool is_retired() const;
+    uint32_t get_generation() const { return _header == NULL ? 0 : _header->generation; }
+
+    // Move to the next sample to be published, or to the oldest one still held
+    void seek_latest();
+    void seek_oldest();
+
+    // Take the next sample. Returns false if there is none yet.
+    bool read(opt3002_shm_sample_t &sample);
+
+    // Samples overwritten before this reader got to them
+    uint64_t get_missed() const { return _missed; }
+
+   private:
+    const opt3002_shm_header_t *_header;
+    const opt3002_shm_slot_t *_slots;
+    size_t _size;
+    uint32_t _mask;
+    uint8_t _shift;  // log2 of the capacity
+    uint64_t _cursor;
+    uint64_t _missed;
+};
+#endif
@@ -0,0 +1,417 @@
+#include "OPT3002_simulator.h"
+
+#include <math.h>
+
+// Register map as given in the OPT3002 datasheet; CONFIG fields come from OPT3002_codec.h
+static const uint8_t REG_RESULT = 0x00;
+static const uint8_t REG_CONFIG = 0x01;
+static const uint8_t REG_LOW_LIMIT = 0x02;
+static const uint8_t REG_HIGH_LIMIT = 0x03;
+static const uint8_t REG_MANUFACTURER_ID = 0x7E;
+static const uint8_t REG_DEVICE_ID = 0x7F;
+
+static const uint16_t HIGH_LIMIT_RESET = opt3002_result_encode(11, 0x0FFF);
+static const uint16_t DEVICE_ID = 0x3001;
+
+static const uint64_t NS_PER_MS = 1000000ULL;
+
+// Modes 10b and 11b are both continuous
+static bool config_continuous(uint16_t config) { return opt3002_config_mode(config) & 0x02; }
+
+// A LOW_LIMIT exponent of 11xxb selects end-of-conversion mode
+static bool end_of_conversion_mode(uint16_t low_limit) { return (opt3002_result_exponent(low_limit) >> 2) == 0x03; }
+
+// Compare limits and results on a common linear scale
+static uint32_t linear_value(uint16_t word) { return uint32_t(opt3002_result_mantissa(word)) << opt3002_result_exponent(word); }
+
+OPT3002Simulator::OPT3002Simulator(uint8_t device_address)
+    : _device_address(device_address),
+      _pin_callback(NULL),
+      _pin_context(NULL),
+      _constant_power(0),
+      _light_source(NULL),
+      _light_context(NULL),
+      _noise_rms(0),
+      _noise_state(1) {
+    reset();
+}
+
+void OPT3002Simulator::reset() {
+    _pointer = REG_RESULT;
+    _result = 0;
+    _config = OPT3002_CONFIG_RESET;
+    _low_limit = 0;
+    _high_limit = HIGH_LIMIT_RESET;
+    _time_ns = 0;
+    _converting = false;
+    _conversion_start_ns = 0;
+    _conversion_length_ns = 0;
+    _conversion_exponent = 0;
+    _interrupt = false;
+    _pin_level = get_int_pin();
+    _fault_high_count = 0;
+    _fault_low_count = 0;
+    _conversions = 0;
+}
+
+void OPT3002Simulator::set_optical_power(float optical_power) {
+    _constant_power = optical_power;
+    _light_source = NULL;
+}
+
+void OPT3002Simulator::set_light_source(opt3002_light_source_t source, void *context) {
+    _light_source = source;
+    _light_context = context;
+}
+
+void OPT3002Simulator::set_noise(float rms, uint32_t seed) {
+    _noise_rms = rms;
+    _noise_state = seed ? seed : 1;
+}
+
+float OPT3002Simulator::sample_light(uint64_t time_ns) {
+    if (_light_source) return _light_source(time_ns, _light_context);
+    return _constant_power;
+}
+
+/**
+ * Average the light level over a conversion window.
+ * Eight evenly spaced samples are enough to show the smoothing a long
+ * integration gives against flicker without making hour-long runs slow.
+ */
+float OPT3002Simulator::integrate_light(uint64_t start_ns, uint64_t end_ns) {
+    if (not _light_source) return _constant_power;
+
+    const uint8_t samples = 8;
+    uint64_t step = (end_ns - start_ns) / samples;
+    float total = 0;
+    for (uint8_t i = 0; i < samples; i++) {
+        total += sample_light(start_ns + step / 2 + step * i);
+    }
+    return total / samples;
+}
+
+/**
+ * Approximately normal noise with unit variance (sum of four uniforms).
+ */
+float OPT3002Simulator::noise() {
+    float total = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        // xorshift32
+        _noise_state ^= _noise_state << 13;
+        _noise_state ^= _noise_state >> 17;
+        _noise_state ^= _noise_state << 5;
+        total += (_noise_state >> 8) * (1.0f / 16777216.0f) - 0.5f;
+    }
+    return total * 1.7320508f;
+}
+
+uint16_t OPT3002Simulator::get_register(uint8_t address) const {
+    switch (address) {
+        case REG_RESULT:
+            return _result;
+        case REG_CONFIG:
+            return _config;
+        case REG_LOW_LIMIT:
+            return _low_limit;
+        case REG_HIGH_LIMIT:
+            return _high_limit;
+        case REG_MANUFACTURER_ID:
+            return OPT3002_MANUFACTURER_ID;
+        case REG_DEVICE_ID:
+            return DEVICE_ID;
+        default:
+            return 0;
+    }
+}
+
+bool OPT3002Simulator::get_int_pin() const {
+    bool active_high = opt3002_config_flag(_config, OPT3002_CONFIG_POLARITY);
+    return active_high ? _interrupt : not _interrupt;
+}
+
+void OPT3002Simulator::set_pin_callback(opt3002_pin_callback_t callback, void *context) {
+    _pin_callback = callback;
+    _pin_context = context;
+}
+
+// Report an edge if the INT pin level has changed
+void OPT3002Simulator::update_pin() {
+    bool level = get_int_pin();
+    if (level == _pin_level) return;
+
+    _pin_level = level;
+    if (_pin_callback) _pin_callback(level, _pin_context);
+}
+
+void OPT3002Simulator::advance_to(uint64_t time_ns) {
+    while (_converting and _conversion_start_ns + _conversion_length_ns <= time_ns) {
+        _time_ns = _conversion_start_ns + _conversion_length_ns;
+        complete_conversion();
+    }
+    if (time_ns > _time_ns) _time_ns = time_ns;
+}
+
+/**
+ * Begin a conversion at the current time.
+ * In auto-range the range is chosen here, from the light level at the start
+ * of the conversion.
+ */
+void OPT3002Simulator::start_conversion() {
+    _converting = true;
+    _conversion_start_ns = _time_ns;
+    _conversion_length_ns = (opt3002_config_conversion_time(_config) ? 800 : 100) * NS_PER_MS;
+
+    uint8_t range = opt3002_config_range(_config);
+    if (range <= 11) {
+        _conversion_exponent = range;
+    } else {
+        float counts = sample_light(_time_ns) / 1.2f;
+        uint8_t exponent = 0;
+        while (exponent < 11 and counts >= 4095.0f) {
+            counts /= 2;
+            exponent++;
+        }
+        _conversion_exponent = exponent;
+    }
+}
+
+void OPT3002Simulator::complete_conversion() {
+    uint64_t end_ns = _conversion_start_ns + _conversion_length_ns;
+    float power = integrate_light(_conversion_start_ns, end_ns);
+    if (_noise_rms > 0) {
+        float scale = opt3002_config_conversion_time(_config) ? 1.0f : 2.8284271f;
+        power += noise() * _noise_rms * scale;
+    }
+    if (power < 0) power = 0;
+
+    uint8_t exponent = _conversion_exponent;
+    float counts = power / (1.2f * float(uint32_t(1) << exponent)) + 0.5f;
+    bool overflow = counts >= 4096.0f;
+    uint16_t mantissa = overflow ? 0x0FFF : uint16_t(counts);
+
+    bool manual = opt3002_config_range(_config) <= 11;
+    bool masked = manual and opt3002_config_flag(_config, OPT3002_CONFIG_MASK_EXPONENT);
+    _result = opt3002_result_encode(masked ? 0 : exponent, mantissa);
+
+    _config = opt3002_config_with_flag(_config, OPT3002_CONFIG_CONVERSION_READY, true);
+    _config = opt3002_config_with_flag(_config, OPT3002_CONFIG_OVERFLOW, overflow);
+    update_faults(uint32_t(mantissa) << exponent);
+    _conversions++;
+    update_pin();
+
+    if (config_continuous(_config)) {
+        start_conversion();
+    } else {
+        // Single-shot conversions return the device to shutdown
+        _config = opt3002_config_with(_config, OPT3002_CONFIG_MODE_MASK, OPT3002_CONFIG_MODE_SHIFT, OPT3002_MODE_SHUTDOWN);
+        _converting = false;
+    }
+}
+
+/**
+ * Run the fault counter and interrupt logic for a new result.
+ * @param value: Result on the linear (mantissa << exponent) scale.
+ */
+void OPT3002Simulator::update_faults(uint32_t value) {
+    bool end_of_conversion = end_of_conversion_mode(_low_limit);
+    bool above = value > linear_value(_high_limit);
+    bool below = not end_of_conversion and value < linear_value(_low_limit);
+
+    _fault_high_count = above ? (_fault_high_count < 0xFF ? _fault_high_count + 1 : 0xFF) : 0;
+    _fault_low_count = below ? (_fault_low_count < 0xFF ? _fault_low_count + 1 : 0xFF) : 0;
+
+    uint8_t required = 1 << opt3002_config_fault_count(_config);
+    bool latched = opt3002_config_flag(_config, OPT3002_CONFIG_LATCH);
+
+    if (_fault_high_count >= required) {
+        _config = opt3002_config_with_flag(_config, OPT3002_CONFIG_FLAG_HIGH, true);
+        if (not latched) _config = opt3002_config_with_flag(_config, OPT3002_CONFIG_FLAG_LOW, false);
+        _interrupt = true;
+    }
+    if (_fault_low_count >= required) {
+        _config = opt3002_config_with_flag(_config, OPT3002_CONFIG_FLAG_LOW, true);
+        if (not latched) _config = opt3002_config_with_flag(_config, OPT3002_CONFIG_FLAG_HIGH, false);
+        _interrupt = latched;
+    }
+    if (end_of_conversion) _interrupt = true;
+}
+
+/**
+ * Apply a host write to CONFIG.
+ * Read-only flags are preserved; mode changes start or stop conversions.
+ */
+void OPT3002Simulator::write_config(uint16_t value) {
+    _config = (_config & OPT3002_CONFIG_READ_ONLY) | (value & ~OPT3002_CONFIG_READ_ONLY);
+
+    uint8_t mode = opt3002_config_mode(_config);
+    if (mode == OPT3002_MODE_SHUTDOWN) {
+        _converting = false;
+    } else if (not config_continuous(_config) or not _converting) {
+        _fault_high_count = 0;
+        _fault_low_count = 0;
+        start_conversion();
+    }
+    update_pin();
+}
+
+/**
+ * Handle the payload of a write transaction.
+ * The first byte is the register pointer; two more bytes write the register.
+ */
+bool OPT3002Simulator::handle_write(const uint8_t *data, size_t length) {
+    if (length == 0) return true;
+
+    _pointer = data[0];
+    if (length < 3) return true;
+
+    uint16_t value = opt3002_unpack(data[1], data[2]);
+    switch (_pointer) {
+        case REG_CONFIG:
+            write_config(value);
+            break;
+        case REG_LOW_LIMIT:
+            _low_limit = value;
+            break;
+        case REG_HIGH_LIMIT:
+            _high_limit = value;
+            break;
+        default:
+            break;  // Read-only or unimplemented
+    }
+    return true;
+}
+
+/**
+ * Handle the payload of a read transaction from the current pointer.
+ * Reading CONFIG clears the conversion-ready flag and, in latched or
+ * end-of-conversion modes, the fault flags and the interrupt.
+ */
+bool OPT3002Simulator::handle_read(uint8_t *data, size_t length) {
+    // Reads longer than a register repeat it
+    uint8_t bytes[2];
+    opt3002_pack(get_register(_pointer), bytes);
+    for (size_t i = 0; i < length; i++) data[i] = bytes[i & 1];
+
+    if (_pointer == REG_CONFIG) {
+        _config = opt3002_config_with_flag(_config, OPT3002_CONFIG_CONVERSION_READY, false);
+        if (opt3002_config_flag(_config, OPT3002_CONFIG_LATCH)) {
+            _config = opt3002_config_with_flag(_config, OPT3002_CONFIG_FLAG_HIGH, false);
+            _config = opt3002_config_with_flag(_config, OPT3002_CONFIG_FLAG_LOW, false);
+            _interrupt = false;
+        }
+        if (end_of_conversion_mode(_low_limit)) _interrupt = false;
+        update_pin();
+    }
+    return true;
+}
+
+OPT3002SimulatedBus::OPT3002SimulatedBus(uint32_t clock_hz) : _device_count(0), _clock_hz(clock_hz), _time_ns(0) {
+    for (uint8_t i = 0; i < MAX_DEVICES; i++) _devices[i] = NULL;
+    reset_counters();
+}
+
+bool OPT3002SimulatedBus::attach(OPT3002Simulator &device) {
+    if (_device_count >= MAX_DEVICES or find(device.get_address())) return false;
+    device.advance_to(_time_ns);
+    _devices[_device_count++] = &device;
+    return true;
+}
+
+void OPT3002SimulatedBus::advance_to(uint64_t time_ns) {
+    if (time_ns > _time_ns) _time_ns = time_ns;
+    for (uint8_t i = 0; i < _device_count; i++) _devices[i]->advance_to(_time_ns);
+}
+
+void OPT3002SimulatedBus::reset_counters() {
+    _transactions = 0;
+    _bytes = 0;
+    _busy_ns = 0;
+}
+
+OPT3002Simulator *OPT3002SimulatedBus::find(uint8_t device_address) {
+    for (uint8_t i = 0; i < _device_count; i++) {
+        if (_devices[i]->get_address() == device_address) return _devices[i];
+    }
+    return NULL;
+}
+
+/**
+ * Account for one transaction and move the clock past it.
+ * @param payload_bytes: Bytes after the address byte.
+ */
+void OPT3002SimulatedBus::occupy(size_t payload_bytes) {
+    _transactions++;
+    _bytes += 1 + payload_bytes;
+    if (_clock_hz == 0) return;
+
+    // START + 9 clocks per byte (8 data + ACK) + STOP
+    uint64_t bits = 2 + 9 * (1 + payload_bytes);
+    uint64_t duration_ns = bits * 1000000000ULL / _clock_hz;
+    _busy_ns += duration_ns;
+    advance(duration_ns);
+}
+
+bool OPT3002SimulatedBus::write(uint8_t device_address, const uint8_t *data, size_t length) {
+    advance_to(_time_ns);
+    OPT3002Simulator *device = find(device_address);
+    bool acknowledged = device and device->handle_write(data, length);
+    occupy(device ? length : 0);
+    return acknowledged;
+}
+
+bool OPT3002SimulatedBus::read(uint8_t device_address, uint8_t *data, size_t length) {
+    advance_to(_time_ns);
+    OPT3002Simulator *device = find(device_address);
+    bool acknowledged = device and device->handle_read(data, length);
+    occupy(device ? length : 0);
+    return acknowledged;
+}
+
+OPT3002DaylightTrace::OPT3002DaylightTrace(float peak, float cloud_cover, uint32_t seed) : _peak(peak), _cloud_cover(cloud_cover), _seed(seed) {}
+
+float OPT3002DaylightTrace::source(uint64_t time_ns, void *context) { return ((OPT3002DaylightTrace *)context)->power_at(time_ns); }
+
+// Smoothly interpolated pseudo-random values in [0, 1] at integer positions
+float OPT3002DaylightTrace::value_noise(float position, uint32_t layer) const {
+    float cell = floorf(position);
+    float fraction = position - cell;
+    float smooth = fraction * fraction * (3 - 2 * fraction);
+
+    float corners[2];
+    for (uint32_t i = 0; i < 2; i++) {
+        uint32_t hash = (uint32_t(int32_t(cell)) + i) * 0x9E3779B1u ^ (_seed + layer * 0x85EBCA6Bu);
+        hash ^= hash >> 15;
+        hash *= 0x2C1B3C6Du;
+        hash ^= hash >> 12;
+        hash *= 0x297A2D39u;
+        hash ^= hash >> 15;
+        corners[i] = (hash >> 8) * (1.0f / 16777216.0f);
+    }
+    return corners[0] + (corners[1] - corners[0]) * smooth;
+}
+
+float OPT3002DaylightTrace::power_at(uint64_t time_ns) const {
+    const float night = 0.5f;            // nW/cm^2: moonlight and stray light
+    const float twilight_width = 0.05f;  // In units of solar elevation below the horizon
+
+    uint64_t seconds = time_ns / 1000000000ULL;
+    float day_seconds = float(seconds % 86400) + float(time_ns % 1000000000ULL) * 1e-9f;
+    float hours = day_seconds / 3600.0f;
+
+    // Solar elevation as a fraction of its noon value, negative at night
+    float elevation = sinf(float(M_PI) * (hours - 6.0f) / 12.0f);
+    float clear = night;
+    if (elevation > 0) {
+        clear += _peak * powf(elevation, 1.3f);
+    } else if (elevation > -twilight_width) {
+        clear += _peak * 1e-3f * (1 + elevation / twilight_width);
+    }
+
+    // Time in whole days keeps float precision over long runs
+    float days = float(seconds / 86400);
+    float slow = value_noise(days * 144.0f + day_seconds / 600.0f, 1);
+    float fast = value_noise(days * 2160.0f + day_seconds / 40.0f, 2);
+    float cloudiness = 0.7f * slow + 0.3f * fast;
+    return clear * (1.0f - 0.85f * _cloud_cover * cloudiness);
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "OPT3002.h"
+#include "OPT3002_clock.h"
+
+/**
+ * Light input for a simulated sensor.
+ * Called with the virtual time in nanoseconds; returns the optical power
+ * falling on the sensor in nW/cm^2.
+ */
+typedef float (*opt3002_light_source_t)(uint64_t time_ns, void *context);
+
+/**
+ * Observer for the simulated INT pin, called with the new level on each edge.
+ */
+typedef void (*opt3002_pin_callback_t)(bool level, void *context);
+
+/**
+ * Deterministic model of a day of outdoor light, for long simulator runs.
+ *
+ * The sun follows a sine from 06:00 to 18:00 with a short twilight either
+ * side and a dim floor at night. Clouds attenuate it with two layers of
+ * smooth value noise, one drifting over about ten minutes and one over about
+ * forty seconds. The light is a pure function of time, so a trace can be
+ * sampled at any point and replays identically for a given seed.
+ *
+ * Example:
+ *   OPT3002DaylightTrace day(2.0e6f, 0.5f);
+ *   sensor.set_light_source(OPT3002DaylightTrace::source, &day);
+ */
+class OPT3002DaylightTrace {
+   public:
+    // peak: clear-sky noon level in nW/cm^2; cloud_cover: 0 (clear) to 1 (overcast)
+    OPT3002DaylightTrace(float peak = 2.0e6f, float cloud_cover = 0.5f, uint32_t seed = 1);
+
+    // Light in nW/cm^2 at a time measured from midnight of the first day
+    float power_at(uint64_t time_ns) const;
+
+    // Adapter for OPT3002Simulator::set_light_source()
+    static float source(uint64_t time_ns, void *context);
+
+   private:
+    float _peak;
+    float _cloud_cover;
+    uint32_t _seed;
+
+    float value_noise(float position, uint32_t layer) const;
+};
+
+/**
+ * Behavioural model of a single OPT3002.
+ *
+ * The model holds the RESULT, CONFIG, LOW_LIMIT, HIGH_LIMIT and ID registers,
+ * the register pointer, and the conversion state machine. Time only moves
+ * when advance() or advance_to() is called, so hours of sensor time can be
+ * covered in a fraction of a second of host time.
+ *
+ * Modelled behaviour:
+ *  - 100ms/800ms conversions in shutdown, single-shot and continuous modes
+ *  - manual ranges, with the overflow flag set when the input exceeds full scale
+ *  - auto-range, which picks its range from the light level at the start of
+ *    each conversion (so large steps overflow once before settling)
+ *  - the fault counter, latched and hysteresis interrupt styles, and the
+ *    end-of-conversion interrupt mode selected through LOW_LIMIT
+ *  - clear-on-read of the flag bits and the INT pin when CONFIG is read
+ *  - the mask-exponent bit in manual range modes
+ */
+class OPT3002Simulator {
+   public:
+    OPT3002Simulator(uint8_t device_address = OPT3002_DEFAULT_ADDRESS);
+
+    // Return every register, the pointer and the clock to power-on state
+    void reset();
+
+    uint8_t get_address() const { return _device_address; }
+
+    // Set a constant light level in nW/cm^2
+    void set_optical_power(float optical_power);
+
+    // Drive the light level from a function of time
+    void set_light_source(opt3002_light_source_t source, void *context);
+
+    // Add white noise to each conversion, specified for 800ms conversions.
+    // 100ms conversions see sqrt(8) times as much.
+    void set_noise(float rms, uint32_t seed = 1);
+
+    // Move the virtual clock forward, completing any conversions on the way
+    void advance(uint64_t duration_ns) { advance_to(_time_ns + duration_ns); }
+    void advance_to(uint64_t time_ns);
+    uint64_t get_time_ns() const { return _time_ns; }
+
+    // Bus side of the device: the payload of an I2C write or read transaction
+    bool handle_write(const uint8_t *data, size_t length);
+    bool handle_read(uint8_t *data, size_t length);
+
+    // Inspect a register without clear-on-read side effects
+    uint16_t get_register(uint8_t address) const;
+    uint8_t get_pointer() const { return _pointer; }
+
+    // Logical state of the interrupt, and the resulting level on the INT pin
+    bool interrupt_asserted() const { return _interrupt; }
+    bool get_int_pin() const;
+
+    // Be told about every edge on the INT pin (e.g. to emulate a GPIO interrupt)
+    void set_pin_callback(opt3002_pin_callback_t callback, void *context);
+
+    // Number of conversions completed since reset
+    uint32_t get_conversions() const { return _conversions; }
+
+   private:
+    uint8_t _device_address;
+    uint8_t _pointer;
+
+    uint16_t _result;
+    uint16_t _config;
+    uint16_t _low_limit;
+    uint16_t _high_limit;
+
+    uint64_t _time_ns;
+    bool _converting;
+    uint64_t _conversion_start_ns;
+    uint64_t _conversion_length_ns;
+    uint8_t _conversion_exponent;
+
+    bool _interrupt;
+    bool _pin_level;
+    opt3002_pin_callback_t _pin_callback;
+    void *_pin_context;
+    uint8_t _fault_high_count;
+    uint8_t _fault_low_count;
+    uint32_t _conversions;
+
+    float _constant_power;
+    opt3002_light_source_t _light_source;
+    void *_light_context;
+    float _noise_rms;
+    uint32_t _noise_state;
+
+    float sample_light(uint64_t time_ns);
+    float integrate_light(uint64_t start_ns, uint64_t end_ns);
+    float noise();
+
+    void start_conversion();
+    void complete_conversion();
+    void update_faults(uint32_t value);
+    void write_config(uint16_t value);
+    void update_pin();
+};
+
+/**
+ * Transport connecting an OPT3002 driver to up to four simulated sensors.
+ *
+ * The bus owns the virtual clock: every transaction advances it by the time
+ * the transaction would occupy the wire at the configured SCL frequency
+ * (start, 9 bits per byte including ACK, stop), and the attached sensors are
+ * brought up to date before they see each transaction. It is also the clock
+ * for code under test, so sleeping on it simply moves virtual time forward.
+ */
+class OPT3002SimulatedBus : public OPT3002Transport, public OPT3002Clock {
+   public:
+    static const uint8_t MAX_DEVICES = 4;
+
+    OPT3002SimulatedBus(uint32_t clock_hz = 100000);
+
+    // Attach a sensor; it answers on its own address
+    bool attach(OPT3002Simulator &device);
+
+    // SCL frequency used for transaction timing. 0 makes transactions free.
+    void set_clock_hz(uint32_t clock_hz) { _clock_hz = clock_hz; }
+
+    void advance(uint64_t duration_ns) { advance_to(_time_ns + duration_ns); }
+    void advance_to(uint64_t time_ns);
+    uint64_t get_time_ns() const { return _time_ns; }
+
+    uint32_t now_us() { return uint32_t(_time_ns / 1000); }
+    void sleep_us(uint32_t duration_us) { advance(uint64_t(duration_us) * 1000); }
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length);
+    bool read(uint8_t device_address, uint8_t *data, size_t length);
+
+    // Bus accounting since construction or the last reset_counters()
+    uint32_t get_transactions() const { return _transactions; }
+    uint32_t get_bytes() const { return _bytes; }
+    uint64_t get_busy_ns() const { return _busy_ns; }
+    void reset_counters();
+
+   private:
+    OPT3002Simulator *_devices[MAX_DEVICES];
+    uint8_t _device_count;
+    uint32_t _clock_hz;
+    uint64_t _time_ns;
+
+    uint32_t _transactions;
+    uint32_t _bytes;
+    uint64_t _busy_ns;
+
+    OPT3002Simulator *find(uint8_t device_address);
+    void occupy(size_t payload_bytes);
+};
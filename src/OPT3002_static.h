@@ -0,0 +1,81 @@
+#pragma once
+
+#include "OPT3002.h"
+
+/**
+ * OPT3002 with its configuration fixed at compile time.
+ *
+ * The CONFIG word is computed as a constant from the template arguments and
+ * invalid combinations are rejected by the compiler. begin() writes that word
+ * straight to the sensor instead of reading the current configuration first.
+ * With a manual range the conversion factor is a constant too, so the read
+ * path is a single multiply of the mantissa and works with the exponent field
+ * masked.
+ *
+ * Example:
+ *   OPT3002Static<OPT3002_RANGE_80K, OPT3002_CONV_TIME_100MS, OPT3002_MODE_CONTINUOUS> sensor;
+ */
+template <opt3002_range_t Range,
+          opt3002_conv_time_t ConversionTime = OPT3002_CONV_TIME_800MS,
+          opt3002_mode_t Mode = OPT3002_MODE_CONTINUOUS,
+          opt3002_interrupt_mode_t InterruptMode = OPT_INT_LATCHED,
+          opt3002_interrupt_polarity_t Polarity = OPT3002_ACTIVE_LOW,
+          opt3002_fault_count_t FaultCount = OPT3002_FAULT_1,
+          bool MaskExponent = false>
+class OPT3002Static : public OPT3002 {
+    static_assert(Range <= OPT3002_RANGE_10M or Range == OPT3002_RANGE_AUTO, "Range must be a manual range or OPT3002_RANGE_AUTO");
+    static_assert(Mode == OPT3002_MODE_SHUTDOWN or Mode == OPT3002_MODE_SINGLE_SHOT or Mode == OPT3002_MODE_CONTINUOUS,
+                  "Mode must be shutdown, single-shot or continuous");
+    static_assert(not MaskExponent or Range != OPT3002_RANGE_AUTO, "The exponent can only be masked in a manual range");
+    static_assert(FaultCount <= OPT3002_FAULT_8, "Fault count must be one of OPT3002_FAULT_*");
+
+   public:
+    // The CONFIG register value for this configuration
+    static constexpr uint16_t config_word() {
+        return opt3002_config_encode(Range, ConversionTime, Mode, InterruptMode == OPT_INT_LATCHED, Polarity == OPT3002_ACTIVE_HIGH, MaskExponent,
+                                     FaultCount);
+    }
+
+    // True if every reading shares one compile-time exponent
+    static constexpr bool fixed_range() { return Range != OPT3002_RANGE_AUTO; }
+
+    // Conversion time in microseconds
+    static constexpr uint32_t conversion_time_us() { return ConversionTime == OPT3002_CONV_TIME_800MS ? 800000UL : 100000UL; }
+
+#if defined(ARDUINO)
+    OPT3002Static() {}
+#endif
+    OPT3002Static(OPT3002Transport &transport) : OPT3002(transport) {}
+
+    // Check the sensor answers, then write the fixed configuration
+    bool begin(uint8_t address = OPT3002_DEFAULT_ADDRESS) {
+        set_address(address);
+        if (not check_comms()) return false;
+
+        opt3002_config_t config;
+        config.raw = config_word();
+        write(config);
+        return not is_config_dirty();
+    }
+
+    using OPT3002::get_optical_power;
+
+    // Optical power of the latest measurement in whole nW/cm^2, rounded down
+    // by the shift-and-add divide of convert_to_nw(). With a manual range the
+    // fixed exponent is put back first, in case it is masked.
+    uint32_t get_optical_power() {
+        opt3002_result_t result;
+        if (not get_result(result)) return 0;
+        if (fixed_range()) result.raw = opt3002_result_encode(Range, opt3002_result_mantissa(result.raw));
+        return convert_to_nw(result);
+    }
+
+    // Optical power of the latest measurement in exact 0.1 nW/cm^2 units.
+    // With a manual range this is one multiply by a compile-time constant.
+    uint32_t get_optical_power_x10() {
+        opt3002_result_t result;
+        if (not get_result(result)) return 0;
+        if (not fixed_range()) return convert_to_nw_x10(result);
+        return uint32_t(opt3002_result_mantissa(result.raw)) * (uint32_t(12) << Range);
+    }
+};
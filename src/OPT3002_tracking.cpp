@@ -0,0 +1,102 @@
+#include "OPT3002_tracking.h"
+
+OPT3002WindowTracker::OPT3002WindowTracker(OPT3002 &sensor, OPT3002Clock &clock)
+    : _sensor(&sensor),
+      _clock(&clock),
+      _callback(NULL),
+      _callback_context(NULL),
+      _band_permille(100),
+      _pending(false),
+      _available(false),
+      _wakeups(0),
+      _limit_writes(0) {}
+
+void OPT3002WindowTracker::set_callback(opt3002_sample_callback_t callback, void *context) {
+    _callback = callback;
+    _callback_context = context;
+}
+
+/**
+ * Configure latched window interrupts and start continuous conversions.
+ * Both limits start at full scale, so the first conversions fall below the
+ * window and the first interrupt centres it on the real light level.
+ */
+bool OPT3002WindowTracker::begin(uint16_t band_permille, opt3002_fault_count_t fault_count, opt3002_conv_time_t conversion_time) {
+    _band_permille = band_permille;
+    _pending = false;
+
+    opt3002_result_t full_scale;
+    full_scale.raw = 0xBFFF;
+    if (not write_limits(full_scale, full_scale)) return false;
+
+    _sensor->set_interrupt_mode(OPT_INT_LATCHED);
+    _sensor->set_fault_count(fault_count);
+    _sensor->set_conversion_time(conversion_time);
+    _sensor->set_mode(OPT3002_MODE_CONTINUOUS);
+    return _sensor->commit();
+}
+
+/**
+ * Set the window to level * (1 -/+ band).
+ * The band is never narrower than two steps of the result's own exponent,
+ * so quantisation alone cannot trip it.
+ * @return: False if either limit could not be written.
+ */
+bool OPT3002WindowTracker::recentre(opt3002_result_t result) {
+    uint64_t level = OPT3002::convert_to_pw(result).picowatts;
+    uint64_t band = level * _band_permille / 1000;
+    uint64_t minimum_band = uint64_t(2 * 1200) << opt3002_result_exponent(result.raw);
+    if (band < minimum_band) band = minimum_band;
+
+    opt3002_result_t low = OPT3002::encode_pw(level > band ? level - band : 0);
+    opt3002_result_t high = OPT3002::encode_pw(level + band);
+
+    return write_limits(low, high);
+}
+
+// Write both limits, counting only the writes that succeed
+bool OPT3002WindowTracker::write_limits(opt3002_result_t low, opt3002_result_t high) {
+    bool low_written = _sensor->set_low_limit(low);
+    if (low_written) _limit_writes++;
+    bool high_written = _sensor->set_high_limit(high);
+    if (high_written) _limit_writes++;
+    return low_written and high_written;
+}
+
+bool OPT3002WindowTracker::service() {
+    if (not _pending) return false;
+    _pending = false;
+    _wakeups++;
+
+    // Reading CONFIG acknowledges the latched interrupt. If any step fails,
+    // stay pending so the next call retries: an unacknowledged INT raises no
+    // new edge, and an unmoved window would leave the tracker stuck.
+    opt3002_config_t flags;
+    if (not _sensor->refresh_flags(flags)) {
+        _pending = true;
+        return false;
+    }
+
+    opt3002_sample_t sample;
+    sample.timestamp_us = _clock->now_us();
+    if (not _sensor->get_result(sample.result)) {
+        _pending = true;
+        return false;
+    }
+    sample.address = _sensor->get_address();
+
+    if (not recentre(sample.result)) {
+        _pending = true;
+        return false;
+    }
+
+    _sample = sample;
+    _available = true;
+    if (_callback) _callback(sample, _callback_context);
+    return true;
+}
+
+opt3002_sample_t OPT3002WindowTracker::take() {
+    _available = false;
+    return _sample;
+}
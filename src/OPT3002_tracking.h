@@ -0,0 +1,63 @@
+#pragma once
+
+#include "OPT3002.h"
+#include "OPT3002_clock.h"
+
+/**
+ * Report-by-exception sampling with a window that follows the light level.
+ *
+ * The sensor converts continuously with latched window interrupts. Whenever
+ * the INT pin fires (the light has left the window for the configured number
+ * of consecutive conversions), service() reads the new level and re-centres
+ * LOW_LIMIT and HIGH_LIMIT around it with a relative band. Under steady light
+ * the host and the bus stay idle.
+ */
+class OPT3002WindowTracker {
+   public:
+    OPT3002WindowTracker(OPT3002 &sensor, OPT3002Clock &clock);
+
+    // Deliver each new level to a callback
+    void set_callback(opt3002_sample_callback_t callback, void *context = NULL);
+
+    // Start tracking. The band is the half-width of the window in parts per
+    // thousand of the current level; fault_count debounces the interrupt.
+    bool begin(uint16_t band_permille = 100, opt3002_fault_count_t fault_count = OPT3002_FAULT_2,
+               opt3002_conv_time_t conversion_time = OPT3002_CONV_TIME_800MS);
+
+    // Call from the INT pin interrupt handler
+    void notify() { _pending = true; }
+
+    // Handle a pending interrupt: read the level and move the window. Returns
+    // true on a new sample; if the sensor could not be read or the window
+    // could not be moved, it stays pending.
+    bool service();
+
+    // Move the window to surround a result
+    bool recentre(opt3002_result_t result);
+
+    // Latest level reported
+    bool available() const { return _available; }
+    opt3002_sample_t take();
+
+    // Interrupts handled, and limit registers successfully written
+    uint32_t get_wakeups() const { return _wakeups; }
+    uint32_t get_limit_writes() const { return _limit_writes; }
+
+   private:
+    OPT3002 *_sensor;
+    OPT3002Clock *_clock;
+
+    opt3002_sample_callback_t _callback;
+    void *_callback_context;
+
+    uint16_t _band_permille;
+    volatile bool _pending;
+
+    opt3002_sample_t _sample;
+    bool _available;
+
+    uint32_t _wakeups;
+    uint32_t _limit_writes;
+
+    bool write_limits(opt3002_result_t low, opt3002_result_t high);
+};
@@ -0,0 +1,129 @@
+#include "OPT3002_transport.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#if defined(ARDUINO)
+bool OPT3002WireTransport::write(uint8_t device_address, const uint8_t *data, size_t length) {
+    _wire.beginTransmission(device_address);
+    _wire.write(data, length);
+    return _wire.endTransmission() == 0;
+}
+
+bool OPT3002WireTransport::read(uint8_t device_address, uint8_t *data, size_t length) {
+    _wire.requestFrom(device_address, (uint8_t)length);
+    size_t i = 0;
+    for (; (i < length) and _wire.available(); i++) {
+        data[i] = _wire.read();
+    }
+    return i == length;
+}
+#endif
+
+#if defined(__linux__) && !defined(ARDUINO)
+OPT3002LinuxTransport::~OPT3002LinuxTransport() { close(); }
+
+/**
+ * Open an i2c-dev adapter node.
+ * @param path: Path to the adapter, e.g. "/dev/i2c-1"
+ * @return: True if the node could be opened for reading and writing.
+ */
+bool OPT3002LinuxTransport::open(const char *path) {
+    close();
+    _fd = ::open(path, O_RDWR | O_CLOEXEC);
+    return _fd >= 0;
+}
+
+bool OPT3002LinuxTransport::open(uint8_t bus) {
+    char path[16];
+    snprintf(path, sizeof(path), "/dev/i2c-%u", bus);
+    return open(path);
+}
+
+void OPT3002LinuxTransport::close() {
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;
+    _slave_address = 0xFF;
+}
+
+/**
+ * Point the adapter at a slave address.
+ * The ioctl is only issued when the address changes.
+ */
+bool OPT3002LinuxTransport::select(uint8_t device_address) {
+    if (_fd < 0) return false;
+    if (_slave_address == device_address) return true;
+
+    if (ioctl(_fd, I2C_SLAVE, device_address) < 0) {
+        _slave_address = 0xFF;
+        return false;
+    }
+    _slave_address = device_address;
+    return true;
+}
+
+bool OPT3002LinuxTransport::write(uint8_t device_address, const uint8_t *data, size_t length) {
+    if (not select(device_address)) return false;
+    return ::write(_fd, data, length) == (ssize_t)length;
+}
+
+bool OPT3002LinuxTransport::read(uint8_t device_address, uint8_t *data, size_t length) {
+    if (not select(device_address)) return false;
+    return ::read(_fd, data, length) == (ssize_t)length;
+}
+#endif
+
+/**
+ * Create an emulated register file holding the sensor's power-on values.
+ * @param device_address: Address the emulated sensor will acknowledge.
+ */
+OPT3002MemoryTransport::OPT3002MemoryTransport(uint8_t device_address) : _device_address(device_address), _pointer(0) {
+    for (size_t i = 0; i < 0x80; i++) _registers[i] = 0;
+    _registers[0x01] = 0xC810;  // CONFIG: auto-range, 800ms, shutdown
+    _registers[0x03] = 0xBFFF;  // HIGH_LIMIT
+    _registers[0x7E] = 0x5449;  // MANUFACTURER_ID ('TI')
+    _registers[0x7F] = 0x3001;  // DEVICE_ID
+    reset_counters();
+}
+
+void OPT3002MemoryTransport::reset_counters() {
+    _transactions = 0;
+    _bytes = 0;
+}
+
+/**
+ * Emulate a write transaction.
+ * The first byte sets the register pointer, the next two (if present) are
+ * written MSB first into the pointed-to register.
+ */
+bool OPT3002MemoryTransport::write(uint8_t device_address, const uint8_t *data, size_t length) {
+    _transactions++;
+    _bytes += 1 + length;
+    if (device_address != _device_address or length == 0) return false;
+
+    _pointer = data[0] & 0x7F;
+    if (length >= 3) {
+        _registers[_pointer] = uint16_t(data[1]) << 8 | data[2];
+    }
+    return true;
+}
+
+/**
+ * Emulate a read transaction from the current register pointer.
+ */
+bool OPT3002MemoryTransport::read(uint8_t device_address, uint8_t *data, size_t length) {
+    _transactions++;
+    _bytes += 1 + length;
+    if (device_address != _device_address) return false;
+
+    uint16_t value = _registers[_pointer];
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (i & 1) ? (value & 0xFF) : (value >> 8);
+    }
+    return true;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#include <Wire.h>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+/**
+ * Bus interface used by the OPT3002 driver.
+ * The driver only ever issues whole I2C transactions (address, payload, stop),
+ * so any backend that can perform a write and a read to a 7-bit address can
+ * carry it: the Arduino TwoWire object, a Linux i2c-dev node, or memory.
+ * Backends that can join a write and a read with a repeated start may
+ * override write_read() to do so.
+ */
+class OPT3002Transport {
+   public:
+    virtual ~OPT3002Transport() {}
+
+    // Write a block of bytes to a device. Returns false if the device NACKs.
+    virtual bool write(uint8_t device_address, const uint8_t *data, size_t length) = 0;
+
+    // Read a block of bytes from a device. Returns false if fewer bytes arrive.
+    virtual bool read(uint8_t device_address, uint8_t *data, size_t length) = 0;
+
+    // Write then read the same device. By default these are two transactions.
+    virtual bool write_read(uint8_t device_address, const uint8_t *data, size_t length, uint8_t *output, size_t output_length) {
+        return write(device_address, data, length) and read(device_address, output, output_length);
+    }
+};
+
+#if defined(ARDUINO)
+/**
+ * Transport backed by an Arduino TwoWire instance (the global Wire by default).
+ * The caller is responsible for calling Wire.begin() before use.
+ */
+class OPT3002WireTransport : public OPT3002Transport {
+   public:
+    OPT3002WireTransport(TwoWire &wire = Wire) : _wire(wire) {}
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length);
+    bool read(uint8_t device_address, uint8_t *data, size_t length);
+
+   private:
+    TwoWire &_wire;
+};
+#endif
+
+#if defined(__linux__) && !defined(ARDUINO)
+/**
+ * Transport backed by a Linux /dev/i2c-N character device.
+ * Each transaction selects the slave address with I2C_SLAVE before issuing
+ * a plain read() or write() on the file descriptor.
+ */
+class OPT3002LinuxTransport : public OPT3002Transport {
+   public:
+    OPT3002LinuxTransport() : _fd(-1), _slave_address(0xFF) {}
+    ~OPT3002LinuxTransport();
+
+    // Open the adapter by path (e.g. "/dev/i2c-1") or by bus number.
+    bool open(const char *path);
+    bool open(uint8_t bus);
+    void close();
+
+    bool is_open() const { return _fd >= 0; }
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length);
+    bool read(uint8_t device_address, uint8_t *data, size_t length);
+
+   private:
+    int _fd;
+    uint8_t _slave_address;
+
+    bool select(uint8_t device_address);
+};
+#endif
+
+/**
+ * Transport that emulates a single OPT3002 register file in memory.
+ * Registers are plain storage: writes land verbatim and reads return the
+ * last value written, so this backend exercises the driver's framing and
+ * lets transactions and bytes on the wire be counted without hardware.
+ */
+class OPT3002MemoryTransport : public OPT3002Transport {
+   public:
+    OPT3002MemoryTransport(uint8_t device_address = 0x44);
+
+    bool write(uint8_t device_address, const uint8_t *data, size_t length);
+    bool read(uint8_t device_address, uint8_t *data, size_t length);
+
+    // Direct access to the emulated registers (big-endian on the wire)
+    uint16_t get_register(uint8_t address) const { return _registers[address & 0x7F]; }
+    void set_register(uint8_t address, uint16_t value) { _registers[address & 0x7F] = value; }
+
+    // Register pointer as last written by the driver
+    uint8_t get_pointer() const { return _pointer; }
+
+    // Bus accounting since construction or the last reset_counters()
+    uint32_t get_transactions() const { return _transactions; }
+    uint32_t get_bytes() const { return _bytes; }
+    void reset_counters();
+
+   private:
+    uint8_t _device_address;
+    uint8_t _pointer;
+    uint16_t _registers[0x80];
+    uint32_t _transactions;
+    uint32_t _bytes;
+};